@@ -54,11 +54,11 @@ private:
 int main(int argc, char** argv) {
   m68k::Registers regs;
   regs.pc = 0;
-  regs.ssp = 0x1400;
-  regs.sr.supervisor = true;
+  regs.set_supervisor(true);
+  regs.set_ssp(0x1400);
 
   EmulatorDevice device{argv[1]};
-  std::ignore = device.Device::write<Long>(regs.ssp, 0xFFFFFF);
+  std::ignore = device.Device::write<Long>(regs.ssp(), 0xFFFFFF);
 
   while (true) {
     const auto begin_pc = regs.pc;
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <filesystem>
@@ -12,7 +13,6 @@
 #include <sstream>
 #include <string>
 #include <string_view>
-#include <thread>
 #include <utility>
 #include <vector>
 
@@ -21,7 +21,9 @@
 #include "lib/common/error/error.h"
 #include "lib/common/memory/device.h"
 #include "lib/common/memory/types.h"
+#include "lib/common/util/thread_pool.h"
 #include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/lanes/lanes.h"
 #include "lib/m68k/registers/registers.h"
 
 using json = nlohmann::json;
@@ -57,7 +59,7 @@ public:
     ferr << "Read memory " << addr << " with size " << size << std::endl;
 
     if (size > 1 && addr % 2 != 0) {
-      return Error{Error::UnalignedMemoryRead, fmt::format("Memory read address: {:08x} size: {:x}", addr, size)};
+      return Error{Error::UnalignedMemoryRead, "Memory read address: {:08x} size: {:x}", addr, size};
     }
 
     for (int i = addr, ptr = 0; i < addr + size; ++i, ++ptr) {
@@ -72,8 +74,7 @@ public:
 
   std::optional<Error> write(AddressType addr, DataView data) override {
     if (data.size() > 1 && addr % 2 != 0) {
-      return Error{Error::UnalignedMemoryWrite,
-                   fmt::format("Memory write address: {:08x} size: {:x}", addr, data.size())};
+      return Error{Error::UnalignedMemoryWrite, "Memory write address: {:08x} size: {:x}", addr, data.size()};
     }
 
     for (const auto value : data) {
@@ -152,16 +153,16 @@ std::optional<std::string> DumpDiff(const Registers& lhs, const Registers& rhs)
   std::vector<std::string> diffs;
 
   for (int i = 0; i < 8; ++i) {
-    if (lhs.d[i] != rhs.d[i])
+    if (lhs.d()[i] != rhs.d()[i])
       diffs.emplace_back("D" + std::to_string(i));
   }
   for (int i = 0; i < 7; ++i) {
-    if (lhs.a[i] != rhs.a[i])
+    if (lhs.a()[i] != rhs.a()[i])
       diffs.emplace_back("A" + std::to_string(i));
   }
-  if (lhs.usp != rhs.usp)
+  if (lhs.usp() != rhs.usp())
     diffs.emplace_back("USP");
-  if (lhs.ssp != rhs.ssp)
+  if (lhs.ssp() != rhs.ssp())
     diffs.emplace_back("SSP");
   if (lhs.pc != rhs.pc)
     diffs.emplace_back("PC");
@@ -182,14 +183,15 @@ std::optional<std::string> DumpDiff(const Registers& lhs, const Registers& rhs)
 Registers ParseRegisters(const json& j) {
   Registers r;
   for (int i = 0; i < 8; ++i) {
-    r.d[i] = j["d" + std::to_string(i)].get<int>();
+    r.d()[i] = j["d" + std::to_string(i)].get<int>();
   }
   for (int i = 0; i < 7; ++i) {
-    r.a[i] = j["a" + std::to_string(i)].get<int>();
+    r.a()[i] = j["a" + std::to_string(i)].get<int>();
   }
-  r.usp = j["usp"].get<int>();
-  r.ssp = j["ssp"].get<int>();
+  // the mode is set first, it defines which stack pointer is banked
   r.sr = j["sr"].get<int>();
+  r.set_usp(j["usp"].get<int>());
+  r.set_ssp(j["ssp"].get<int>());
   r.pc = j["pc"].get<int>();
   return r;
 }
@@ -226,10 +228,24 @@ bool WorkOnTest(const json& test) {
     ferr << "names not match: \"" << printed << "\" versus \"" << inst_name << "\"" << std::endl;
   }
 
+  // the same instruction on the lanes, they don't touch the memory
+  std::optional<Registers> laneRegs;
+  if (can_execute_on_lanes(*inst)) {
+    thread_local LaneRegisters lanes;
+    laneRegs = actualRegs;
+    lanes.load(0, *laneRegs);
+    execute_on_lanes(*inst, lanes, 1);
+    lanes.store(0, *laneRegs);
+  }
+
   // execute
   const auto err = inst->execute(ctx);
   if (err) {
     ferr << "execute error: " << err->what() << std::endl;
+    if (laneRegs) {
+      ferr << "lanes executed the instruction that failed" << std::endl;
+      return false;
+    }
 
     // this program counter means there really was an illegal instruction
     return (expectedRegs.pc == 0x1400);
@@ -239,6 +255,7 @@ bool WorkOnTest(const json& test) {
   const auto expectedRam1 = GetRamSnapshot(finalJson["ram"]);
 
   const auto regsDiff = DumpDiff(expectedRegs, actualRegs);
+  const auto lanesDiff = laneRegs ? DumpDiff(actualRegs, *laneRegs) : std::nullopt;
   bool ramDiffers = GetRamDiff(actualRam0, actualRam1) != GetRamDiff(expectedRam0, expectedRam1);
 
   // because of some bugs in data
@@ -246,6 +263,14 @@ bool WorkOnTest(const json& test) {
     ramDiffers = false;
   }
 
+  if (lanesDiff) {
+    ferr << "Test name: \"" << test_name << "\"" << std::endl << std::endl;
+    ferr << "Lanes final registers:" << std::endl;
+    ferr << dump(*laneRegs) << std::endl;
+    ferr << "Registers differing from execute: " << *lanesDiff << std::endl << std::endl;
+    return false;
+  }
+
   if (regsDiff || ramDiffers) {
     ferr << "Test name: \"" << test_name << "\"" << std::endl << std::endl;
 
@@ -333,47 +358,33 @@ int main() {
 
   const auto shouldRunTest = [](int /*index*/) { return true; };
 
-  constexpr int threadCount = 10;
   std::mutex mut;
-  int curIndex = 1;
-  int totalCount = 0;
+  std::atomic_int totalCount = 0;
 
   fs::remove_all("logs");
   fs::create_directories("logs");
 
-  std::vector<std::thread> threads;
-  for (int i = 0; i < threadCount; ++i) {
-    threads.emplace_back([&]() {
-      while (true) {
-        std::string path;
-        {
-          std::lock_guard guard{mut};
-          while (curIndex <= paths.size() && !shouldRunTest(curIndex)) {
-            path = paths[curIndex - 1];
-            std::cerr << "NOT working on file " << path.substr(path.rfind('/') + 1) << " [index " << curIndex << "]"
-                      << std::endl;
-            ++curIndex;
-          }
-          if (curIndex > paths.size()) {
-            return;
-          }
-          path = paths[curIndex - 1];
-          std::cerr << "working on file " << path.substr(path.rfind('/') + 1) << std::endl;
-          ++curIndex;
-          ++totalCount;
-        }
-
-        std::string part = path.substr(path.rfind('/') + 1);
-        part = part.substr(0, part.rfind('.'));
-        ferr = std::ofstream{"logs/" + part};
-
-        auto file = LoadTestFile(path);
-        WorkOnFile(file);
-      }
-    });
-  }
-  for (auto& t : threads) {
-    t.join();
-  }
-  std::cerr << "Total file count: " << totalCount << std::endl;
+  ThreadPool pool;
+  pool.parallel_for(0, paths.size(), [&](std::size_t index) {
+    const auto& path = paths[index];
+    if (!shouldRunTest(index + 1)) {
+      std::lock_guard guard{mut};
+      std::cerr << "NOT working on file " << path.substr(path.rfind('/') + 1) << " [index " << index + 1 << "]"
+                << std::endl;
+      return;
+    }
+    {
+      std::lock_guard guard{mut};
+      std::cerr << "working on file " << path.substr(path.rfind('/') + 1) << std::endl;
+    }
+    ++totalCount;
+
+    std::string part = path.substr(path.rfind('/') + 1);
+    part = part.substr(0, part.rfind('.'));
+    ferr = std::ofstream{"logs/" + part};
+
+    auto file = LoadTestFile(path);
+    WorkOnFile(file);
+  });
+  std::cerr << "Total file count: " << totalCount.load() << std::endl;
 }
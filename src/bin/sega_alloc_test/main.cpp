@@ -0,0 +1,114 @@
+#include "lib/sega/headless/headless.h"
+#include "spdlog/common.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/core.h>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+// only the allocations of the emulation thread in the measured frames are counted
+thread_local bool count_allocations = false;
+thread_local uint64_t allocations = 0;
+
+void* allocate(std::size_t size, std::size_t alignment) {
+  if (count_allocations) {
+    ++allocations;
+  }
+  size = (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment;
+  if (void* ptr = std::aligned_alloc(alignment, size)) {
+    return ptr;
+  }
+  std::abort();
+}
+
+} // namespace
+
+// the array and nothrow forms call these ones
+void* operator new(std::size_t size) {
+  return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+namespace sega {
+
+int main(int argc, char** argv) {
+  spdlog::set_level(spdlog::level::warn);
+
+  assert(argc == 4);
+  const auto rom_path = std::filesystem::path{argv[1]};
+  const auto warmup_frames = std::stoull(argv[2]);
+  const auto frames = std::stoull(argv[3]);
+
+  // the first frames find new code and fill the caches
+  HeadlessRunner runner{make_run_options(rom_path, warmup_frames + frames)};
+  for (uint64_t i = 0; i < warmup_frames && runner.run_frame(); ++i) {
+  }
+  const auto warmed_up_frames = runner.report().frames;
+
+  // the allocating frames are kept in a vector reserved before counting
+  std::vector<uint64_t> allocating_frames;
+  allocating_frames.reserve(frames);
+  uint64_t total = 0;
+  for (uint64_t i = 0; i < frames; ++i) {
+    allocations = 0;
+    count_allocations = true;
+    const bool running = runner.run_frame();
+    count_allocations = false;
+    if (allocations > 0) {
+      allocating_frames.push_back(warmed_up_frames + i);
+      total += allocations;
+    }
+    if (!running) {
+      break;
+    }
+  }
+
+  const auto& report = runner.report();
+  // a ROM that aborts would pass with the frames it didn't run
+  const auto measured_frames = report.frames - warmed_up_frames;
+  if (report.aborted || warmed_up_frames != warmup_frames || measured_frames != frames) {
+    fmt::print("FAIL: ran {} of {} warmup frames and {} of {} measured frames{}\n", warmed_up_frames, warmup_frames,
+               measured_frames, frames, report.aborted ? ", aborted" : "");
+    return 1;
+  }
+  if (total > 0) {
+    fmt::print("FAIL: {} allocations in {} of {} frames, the first in frame {}\n", total, allocating_frames.size(),
+               measured_frames, allocating_frames.front());
+    return 1;
+  }
+  fmt::print("OK: no allocations in {} frames ({} faults)\n", measured_frames, report.faults);
+  return 0;
+}
+
+} // namespace sega
+
+int main(int argc, char** argv) {
+  return sega::main(argc, argv);
+}
@@ -0,0 +1,58 @@
+#include "lib/sega/batch/batch_runner.h"
+#include "spdlog/common.h"
+#include "spdlog/spdlog.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fmt/core.h>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace sega {
+
+namespace {
+
+// the buttons are held for this number of frames
+constexpr uint64_t kInputPeriod = 16;
+
+// the first lane gets no input, so its hash is the same as of `sega_bench`, the other lanes press random buttons
+uint8_t random_input(size_t lane, uint64_t frame) {
+  if (lane == 0) {
+    return 0;
+  }
+  std::minstd_rand random{static_cast<uint32_t>(lane * 1000003 + frame / kInputPeriod)};
+  return static_cast<uint8_t>(random());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  spdlog::set_level(spdlog::level::warn);
+
+  assert(argc == 4);
+  BatchRunner runner{{
+      .rom_path = std::filesystem::path{argv[1]},
+      .lanes = std::stoull(argv[2]),
+      .frames = std::stoull(argv[3]),
+      .input = random_input,
+  }};
+  const auto report = runner.run();
+
+  constexpr std::string_view kRowFormat = "{:>6} {:>8} {:>14} {:>18} {:>8}\n";
+  fmt::print(kRowFormat, "Lane", "Frames", "Instructions", "Hash", "Faults");
+  for (size_t i = 0; i < report.lanes.size(); ++i) {
+    const auto& lane = report.lanes[i];
+    const auto faults = lane.aborted ? fmt::format("{} (!)", lane.faults) : std::to_string(lane.faults);
+    fmt::print(kRowFormat, i, lane.frames, lane.instructions, fmt::format("{:016x}", lane.frame_hash), faults);
+  }
+  fmt::print("FPS: {:.1f}, MIPS: {:.2f}, on lanes: {:.1f}%\n", report.fps(), report.mips(), report.lane_percent());
+  return 0;
+}
+
+} // namespace sega
+
+int main(int argc, char** argv) {
+  return sega::main(argc, argv);
+}
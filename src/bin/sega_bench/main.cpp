@@ -0,0 +1,170 @@
+#include "lib/common/util/thread_pool.h"
+#include "lib/m68k/instruction/fusion.h"
+#include "lib/sega/executor/accuracy.h"
+#include "lib/sega/headless/headless.h"
+#include "lib/sega/metrics/metrics.h"
+#include "lib/sega/metrics/metrics_server.h"
+#include "lib/sega/perf/perf_counters.h"
+#include "magic_enum/magic_enum.hpp"
+#include "spdlog/common.h"
+#include "spdlog/spdlog.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fmt/core.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sega {
+
+namespace {
+
+constexpr std::string_view kMetricsOption = "--metrics=";
+
+void print_table(const std::vector<RunReport>& reports) {
+  constexpr std::string_view kRowFormat = "{:<40} {:>8} {:>10} {:>8} {:>8} {:>8} {:>8} {:>18} {:>8}\n";
+  fmt::print(kRowFormat, "ROM", "Frames", "FPS", "MIPS", "Fused", "Lag", "Idle", "Hash", "Faults");
+
+  RunReport total{.rom_name = "total"};
+  for (const auto& report : reports) {
+    const auto hash = fmt::format("{:016x}", report.frame_hash);
+    const auto faults = report.aborted ? fmt::format("{} (!)", report.faults) : std::to_string(report.faults);
+    fmt::print(kRowFormat, report.rom_name, report.frames, fmt::format("{:.1f}", report.fps()),
+               fmt::format("{:.2f}", report.mips()), fmt::format("{:.1f}%", report.fused_percent()), report.lag_frames,
+               fmt::format("{:.1f}%", report.idle_percent()), hash, faults);
+
+    total.frames += report.frames;
+    total.instructions += report.instructions;
+    total.cycles += report.cycles;
+    total.idle_cycles += report.idle_cycles;
+    total.lag_frames += report.lag_frames;
+    for (size_t i = 0; i < total.fused.size(); ++i) {
+      total.fused[i] += report.fused[i];
+    }
+    total.host_seconds += report.host_seconds;
+    total.faults += report.faults;
+  }
+  fmt::print(kRowFormat, total.rom_name, total.frames, fmt::format("{:.1f}", total.fps()),
+             fmt::format("{:.2f}", total.mips()), fmt::format("{:.1f}%", total.fused_percent()), total.lag_frames,
+             fmt::format("{:.1f}%", total.idle_percent()), "", total.faults);
+}
+
+// null if the counters are unavailable or not enabled, the missing events are null too
+nlohmann::json perf_json(const PerfReport& report) {
+  if (!report.available) {
+    return nullptr;
+  }
+  auto json = nlohmann::json::object();
+  for (const auto phase : magic_enum::enum_values<PerfPhase>()) {
+    auto& counts = json[magic_enum::enum_name(phase)];
+    for (const auto event : magic_enum::enum_values<PerfEvent>()) {
+      counts[magic_enum::enum_name(event)] =
+          report.supported[std::to_underlying(event)] ? nlohmann::json(report.count(phase, event)) : nullptr;
+    }
+  }
+  return json;
+}
+
+void save_json(std::string_view path, const std::vector<RunReport>& reports) {
+  auto json = nlohmann::json::array();
+  for (const auto& report : reports) {
+    auto fused = nlohmann::json::object();
+    for (const auto fusion : magic_enum::enum_values<m68k::Fusion>()) {
+      if (fusion != m68k::Fusion::None) {
+        fused[magic_enum::enum_name(fusion)] = report.fused[std::to_underlying(fusion)];
+      }
+    }
+    json.push_back({
+        {"rom", report.rom_name},
+        {"frames", report.frames},
+        {"instructions", report.instructions},
+        {"cycles", report.cycles},
+        {"idle_cycles", report.idle_cycles},
+        {"idle_percent", report.idle_percent()},
+        {"lag_frames", report.lag_frames},
+        {"fused", fused},
+        {"host_seconds", report.host_seconds},
+        {"fps", report.fps()},
+        {"mips", report.mips()},
+        {"frame_hash", fmt::format("{:016x}", report.frame_hash)},
+        {"sound_hash", fmt::format("{:016x}", report.sound_hash)},
+        {"perf", perf_json(report.perf)},
+        {"faults", report.faults},
+        {"aborted", report.aborted},
+    });
+  }
+  std::ofstream file{path.data()};
+  file << json.dump(2) << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  spdlog::set_level(spdlog::level::warn);
+
+  // options may follow the positional arguments
+  std::vector<std::string_view> arguments;
+  bool accurate = false;
+  bool sound = false;
+  bool perf = false;
+  std::optional<std::string_view> metrics_address;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view argument{argv[i]};
+    if (argument == "--accurate") {
+      accurate = true;
+    } else if (argument == "--sound") {
+      sound = true;
+    } else if (argument == "--perf") {
+      perf = true;
+    } else if (argument.starts_with(kMetricsOption)) {
+      metrics_address = argument.substr(kMetricsOption.size());
+    } else {
+      arguments.push_back(argument);
+    }
+  }
+  assert(arguments.size() == 2 || arguments.size() == 3);
+  const auto rom_directory = std::filesystem::path{arguments[0]};
+  const auto frames = std::stoull(std::string{arguments[1]});
+  const auto accuracy = accurate ? Accuracy::Accurate : Accuracy::Fast;
+
+  // all runners add to the same counters
+  Metrics metrics;
+  std::optional<MetricsServer> metrics_server;
+  if (metrics_address) {
+    metrics_server.emplace(metrics);
+    if (!metrics_server->start(*metrics_address)) {
+      return 1;
+    }
+  }
+
+  const auto roms = find_roms(rom_directory);
+  std::vector<RunReport> reports(roms.size());
+
+  // one ROM per task, the pool balances them over all cores
+  ThreadPool::shared().parallel_for(0, roms.size(), [&](size_t index) {
+    auto options = make_run_options(roms[index], frames, accuracy);
+    options.metrics = metrics_address ? &metrics : nullptr;
+    options.sound = sound;
+    options.perf = perf;
+    HeadlessRunner runner{std::move(options)};
+    reports[index] = runner.run();
+  });
+
+  print_table(reports);
+  if (arguments.size() == 3) {
+    save_json(arguments[2], reports);
+  }
+  return 0;
+}
+
+} // namespace sega
+
+int main(int argc, char** argv) {
+  return sega::main(argc, argv);
+}
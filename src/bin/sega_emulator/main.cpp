@@ -1,25 +1,78 @@
 #include <glad/gl.h>
 
+#include "lib/sega/executor/accuracy.h"
+#include "lib/sega/executor/backend.h"
 #include "lib/sega/executor/executor.h"
+#include "lib/sega/executor/timing.h"
 #include "lib/sega/gui/gui.h"
+#include "lib/sega/metrics/metrics.h"
+#include "lib/sega/metrics/metrics_server.h"
 #include "spdlog/common.h"
 #include "spdlog/spdlog.h"
 #include <cassert>
+#include <optional>
 #include <string_view>
+#include <vector>
 
 namespace sega {
 
+namespace {
+
+constexpr std::string_view kMetricsOption = "--metrics=";
+constexpr std::string_view kBeamRacingOption = "--beam-racing";
+constexpr std::string_view kPerfOption = "--perf";
+
+} // namespace
+
 int main(int argc, char** argv) {
   spdlog::set_level(spdlog::level::info);
 
-  assert(argc == 2);
-  const auto rom_path = std::string_view{argv[1]};
-  Executor executor{rom_path};
+  // options may follow the positional arguments
+  std::vector<std::string_view> arguments;
+  std::optional<std::string_view> metrics_address;
+  bool beam_racing = false;
+  bool perf = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view argument{argv[i]};
+    if (argument.starts_with(kMetricsOption)) {
+      metrics_address = argument.substr(kMetricsOption.size());
+    } else if (argument == kBeamRacingOption) {
+      beam_racing = true;
+    } else if (argument == kPerfOption) {
+      perf = true;
+    } else {
+      arguments.push_back(argument);
+    }
+  }
+  assert(arguments.size() == 1 || arguments.size() == 2);
+  const auto rom_path = arguments[0];
+  // the beam exists only in the emulated time, the GUI paces the frames itself then;
+  // the raster effects need the cycle-accurate beam position and the HBLANK interrupts of the accurate tier
+  Executor executor{rom_path, beam_racing ? Timing::Emulated : Timing::RealTime, Backend::Fast,
+                    beam_racing ? Accuracy::Accurate : Accuracy::Fast};
+  if (arguments.size() == 2 && !executor.load_recompiled_code(arguments[1])) {
+    return 1;
+  }
 
   Gui gui{executor};
   if (!gui.setup()) {
     return 1;
   }
+  gui.set_beam_racing(beam_racing);
+  if (perf) {
+    gui.enable_perf_counters();
+  }
+
+  Metrics metrics;
+  std::optional<MetricsServer> metrics_server;
+  if (metrics_address) {
+    metrics_server.emplace(metrics);
+    if (!metrics_server->start(*metrics_address)) {
+      return 1;
+    }
+    gui.set_metrics(metrics);
+  }
+
   gui.loop();
   return 0;
 }
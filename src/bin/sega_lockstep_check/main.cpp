@@ -0,0 +1,34 @@
+#include "fmt/core.h"
+#include "lib/sega/lockstep/lockstep.h"
+#include "spdlog/common.h"
+#include "spdlog/spdlog.h"
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace sega {
+
+int main(int argc, char** argv) {
+  spdlog::set_level(spdlog::level::warn);
+
+  assert(argc == 3 || argc == 4);
+  const auto rom_path = std::filesystem::path{argv[1]};
+  const auto instructions = std::stoull(argv[2]);
+  const auto recompiled_path = (argc == 4) ? std::optional<std::filesystem::path>{argv[3]} : std::nullopt;
+
+  LockstepChecker checker{rom_path, recompiled_path};
+  if (const auto divergence = checker.run(instructions)) {
+    fmt::print("{}", divergence->dump());
+    return 1;
+  }
+  fmt::print("no divergence in {} instructions and {} frames\n", checker.instructions(), checker.frames());
+  return 0;
+}
+
+} // namespace sega
+
+int main(int argc, char** argv) {
+  return sega::main(argc, argv);
+}
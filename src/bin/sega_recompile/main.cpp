@@ -0,0 +1,43 @@
+#include "lib/common/util/hash.h"
+#include "lib/common/util/thread_pool.h"
+#include "lib/sega/recompiler/code_walker.h"
+#include "lib/sega/recompiler/emitter.h"
+#include "lib/sega/rom_loader/rom_loader.h"
+#include "spdlog/common.h"
+#include "spdlog/spdlog.h"
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+
+namespace sega {
+
+int main(int argc, char** argv) {
+  spdlog::set_level(spdlog::level::info);
+
+  assert(argc == 3);
+  const auto rom_path = std::string_view{argv[1]};
+  const auto output_path = std::string_view{argv[2]};
+
+  const auto rom = load_rom(rom_path);
+  const auto rom_view = DataView{reinterpret_cast<const Byte*>(rom.data()), rom.size()};
+
+  // walk the code reachable from the exception vectors
+  CodeWalker walker{rom_view, ThreadPool::shared()};
+  walker.add_vector_table_entry_points();
+  walker.walk();
+
+  const auto blocks = walker.basic_blocks();
+  spdlog::info("found {} instructions in {} basic blocks", walker.instructions().size(), blocks.size());
+
+  std::ofstream file{output_path.data()};
+  file << emit_recompiled_source(rom_view, blocks, fnv1a(rom_view));
+  spdlog::info("saved recompiled code to {}", output_path);
+  return 0;
+}
+
+} // namespace sega
+
+int main(int argc, char** argv) {
+  return sega::main(argc, argv);
+}
@@ -0,0 +1,78 @@
+#include "lib/common/util/thread_pool.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fmt/core.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// a task doing `work` iterations of a cheap hash, the result is written to `sink` so it can't be optimized away
+void spin(size_t work, std::atomic<uint64_t>& sink) {
+  uint64_t value = work;
+  for (size_t i = 0; i < work; ++i) {
+    value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+  }
+  sink += value;
+}
+
+double measure(const std::function<void()>& func) {
+  const auto begin = std::chrono::steady_clock::now();
+  func();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  assert(argc == 1 || argc == 2);
+  const size_t task_count = argc == 2 ? std::stoull(argv[1]) : 1000;
+
+  ThreadPool pool;
+  ThreadPool pinned_pool{{.pin_threads = true}};
+  std::atomic<uint64_t> sink{};
+
+  constexpr std::string_view kRowFormat = "{:>10} {:>16} {:>16} {:>16} {:>16}\n";
+  fmt::print("{} tasks, {} threads in the pool\n", task_count, pool.thread_count());
+  fmt::print(kRowFormat, "work", "thread/task ms", "task group ms", "parallel_for ms", "pinned ms");
+
+  for (const size_t work : {100, 10'000, 1'000'000}) {
+    const auto thread_per_task = measure([&] {
+      std::vector<std::thread> threads;
+      threads.reserve(task_count);
+      for (size_t i = 0; i < task_count; ++i) {
+        threads.emplace_back([&] { spin(work, sink); });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    });
+
+    const auto task_group = measure([&] {
+      TaskGroup group{pool};
+      for (size_t i = 0; i < task_count; ++i) {
+        group.run([&] { spin(work, sink); });
+      }
+      group.wait();
+    });
+
+    const auto parallel_for =
+        measure([&] { pool.parallel_for(0, task_count, [&](size_t /*index*/) { spin(work, sink); }); });
+
+    const auto pinned =
+        measure([&] { pinned_pool.parallel_for(0, task_count, [&](size_t /*index*/) { spin(work, sink); }); });
+
+    fmt::print(kRowFormat, work, fmt::format("{:.2f}", thread_per_task), fmt::format("{:.2f}", task_group),
+               fmt::format("{:.2f}", parallel_for), fmt::format("{:.2f}", pinned));
+  }
+
+  fmt::print("checksum: {:x}\n", sink.load());
+  return 0;
+}
@@ -1,7 +1,14 @@
 #pragma once
-#include <string>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
 #include <utility>
 
+#include "fmt/format.h"
+
+// the message is formatted into a fixed buffer (and truncated), so making an error never allocates
 class Error {
 public:
   enum Kind {
@@ -28,17 +35,30 @@ public:
   };
 
   Error() = default;
-  Error(Kind kind, std::string what): kind_{kind}, what_{std::move(what)}
-  {}
+  Error(Kind kind, std::string_view what): kind_{kind}, size_{static_cast<uint8_t>(std::min(what.size(), kMaxSize))}
+  {
+    std::copy_n(what.data(), size_, what_.data());
+  }
+
+  template<typename... Args>
+    requires(sizeof...(Args) > 0)
+  Error(Kind kind, fmt::format_string<Args...> format, Args&&... args): kind_{kind}
+  {
+    const auto result = fmt::format_to_n(what_.data(), kMaxSize, format, std::forward<Args>(args)...);
+    size_ = static_cast<uint8_t>(std::min(result.size, kMaxSize));
+  }
 
   Kind kind() const {
     return kind_;
   }
-  const std::string& what() const {
-    return what_;
+  std::string_view what() const {
+    return {what_.data(), size_};
   }
 
 private:
+  static constexpr size_t kMaxSize = 123;
+
   Kind kind_{Ok};
-  std::string what_;
+  uint8_t size_{};
+  std::array<char, kMaxSize> what_;
 };
@@ -1,11 +1,9 @@
 #pragma once
 #include <bit>
 #include <expected>
-#include <fmt/core.h>
 #include <optional>
 #include <utility>
 
-#include "fmt/format.h"
 #include "lib/common/error/error.h"
 #include "spdlog/spdlog.h"
 #include "types.h"
@@ -48,20 +46,17 @@ private:
 class WriteOnlyDevice : public Device {
 private:
   std::optional<Error> read(AddressType addr, MutableDataView data) override {
-    return Error{Error::ProtectedRead,
-                       fmt::format("protected read address: {:06x} size: {:x}", addr, data.size())};
+    return Error{Error::ProtectedRead, "protected read address: {:06x} size: {:x}", addr, data.size()};
   }
 };
 
 class DummyDevice final : public Device {
 private:
   std::optional<Error> write(AddressType addr, DataView data) override {
-    return Error{Error::ProtectedWrite,
-                       fmt::format("protected write address: {:06x} size: {:x}", addr, data.size())};
+    return Error{Error::ProtectedWrite, "protected write address: {:06x} size: {:x}", addr, data.size()};
   }
 
   std::optional<Error> read(AddressType addr, MutableDataView data) override {
-    return Error{Error::ProtectedRead,
-                       fmt::format("protected read address: {:06x} size: {:x}", addr, data.size())};
+    return Error{Error::ProtectedRead, "protected read address: {:06x} size: {:x}", addr, data.size()};
   }
 };
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+// FNV-1a hash, stable across runs and platforms
+constexpr uint64_t kFnvOffsetBasis = 0xCBF29CE484222325;
+constexpr uint64_t kFnvPrime = 0x100000001B3;
+
+constexpr uint64_t fnv1a(std::span<const uint8_t> data, uint64_t hash = kFnvOffsetBasis) {
+  for (const auto byte : data) {
+    hash ^= byte;
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
@@ -0,0 +1,218 @@
+#include "thread_pool.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// the pool and the worker index of the current thread
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+void pin_thread(std::thread& thread, size_t cpu) {
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  if (const int error = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set); error != 0) {
+    spdlog::warn("can't pin thread to CPU {}, error: {}", cpu, error);
+  }
+#else
+  spdlog::warn("thread pinning is not supported on this platform");
+#endif
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(Options options) {
+  const size_t hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  const size_t thread_count = options.thread_count ? options.thread_count : hardware_threads;
+
+  workers_.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    workers_.emplace_back(std::make_unique<Worker>());
+  }
+
+  threads_.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back([this, i] { worker_loop(i); });
+    if (options.pin_threads) {
+      pin_thread(threads_.back(), i % hardware_threads);
+    }
+  }
+}
+
+ThreadPool::ThreadPool() : ThreadPool(Options{}) {}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock{sleep_mutex_};
+    stop_ = true;
+  }
+  sleep_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+ThreadPool& ThreadPool::shared() {
+  static ThreadPool pool;
+  return pool;
+}
+
+size_t ThreadPool::thread_count() const {
+  return threads_.size();
+}
+
+void ThreadPool::submit(Task task, const TaskGroup* group) {
+  const size_t index = current_pool == this ? current_worker : next_worker_++ % workers_.size();
+  {
+    auto& worker = *workers_[index];
+    std::lock_guard lock{worker.mutex};
+    worker.tasks.push_back({std::move(task), group});
+  }
+  {
+    std::lock_guard lock{sleep_mutex_};
+    ++pending_;
+  }
+  sleep_cv_.notify_one();
+}
+
+bool ThreadPool::run_pending_task(const TaskGroup* group) {
+  const size_t index = current_pool == this ? current_worker : next_worker_++ % workers_.size();
+  auto task = pop_task(index, group);
+  if (!task) {
+    task = steal_task(index, group);
+  }
+  if (!task) {
+    return false;
+  }
+  (*task)();
+  return true;
+}
+
+void ThreadPool::parallel_for(size_t begin, size_t end, const std::function<void(size_t)>& body, size_t grain) {
+  if (begin >= end) {
+    return;
+  }
+  grain = std::max<size_t>(grain, 1);
+
+  // each task takes the next chunk until the range is exhausted
+  std::atomic_size_t next{begin};
+  const auto run_chunks = [&] {
+    for (size_t chunk = next.fetch_add(grain); chunk < end; chunk = next.fetch_add(grain)) {
+      for (size_t index = chunk; index < std::min(chunk + grain, end); ++index) {
+        body(index);
+      }
+    }
+  };
+
+  const size_t chunk_count = (end - begin + grain - 1) / grain;
+  const size_t task_count = std::min(chunk_count, thread_count());
+  TaskGroup group{*this};
+  for (size_t i = 1; i < task_count; ++i) {
+    group.run(run_chunks);
+  }
+  run_chunks();
+  group.wait();
+}
+
+void ThreadPool::worker_loop(size_t index) {
+  current_pool = this;
+  current_worker = index;
+
+  while (true) {
+    if (run_pending_task()) {
+      continue;
+    }
+    std::unique_lock lock{sleep_mutex_};
+    sleep_cv_.wait(lock, [this] { return stop_ || pending_ > 0; });
+    if (stop_ && pending_ <= 0) {
+      return;
+    }
+  }
+}
+
+std::optional<ThreadPool::Task> ThreadPool::pop_task(size_t index, const TaskGroup* group) {
+  auto& worker = *workers_[index];
+  std::lock_guard lock{worker.mutex};
+  const auto it = std::find_if(worker.tasks.rbegin(), worker.tasks.rend(),
+                               [group](const QueuedTask& queued) { return !group || queued.group == group; });
+  if (it == worker.tasks.rend()) {
+    return std::nullopt;
+  }
+  auto task = std::move(it->task);
+  worker.tasks.erase(std::next(it).base());
+  --pending_;
+  return task;
+}
+
+std::optional<ThreadPool::Task> ThreadPool::steal_task(size_t thief_index, const TaskGroup* group) {
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    auto& worker = *workers_[(thief_index + i) % workers_.size()];
+    std::lock_guard lock{worker.mutex};
+    const auto it = std::find_if(worker.tasks.begin(), worker.tasks.end(),
+                                 [group](const QueuedTask& queued) { return !group || queued.group == group; });
+    if (it == worker.tasks.end()) {
+      continue;
+    }
+    auto task = std::move(it->task);
+    worker.tasks.erase(it);
+    --pending_;
+    return task;
+  }
+  return std::nullopt;
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool) : pool_{pool} {}
+
+TaskGroup::~TaskGroup() {
+  wait();
+}
+
+void TaskGroup::run(ThreadPool::Task task) {
+  {
+    std::lock_guard lock{mutex_};
+    ++unfinished_;
+  }
+  pool_.submit(
+      [this, task = std::move(task)] {
+        task();
+        // notified under the lock, the waiter may destroy the group right after it
+        std::lock_guard lock{mutex_};
+        --unfinished_;
+        ++events_;
+        cv_.notify_all();
+      },
+      this);
+  // the task is in a deque now, the waiter may take it
+  std::lock_guard lock{mutex_};
+  ++events_;
+  cv_.notify_all();
+}
+
+void TaskGroup::wait() {
+  std::unique_lock lock{mutex_};
+  while (unfinished_ > 0) {
+    const auto events = events_;
+    lock.unlock();
+    const bool ran = pool_.run_pending_task(this);
+    lock.lock();
+    if (!ran) {
+      cv_.wait(lock, [&] { return unfinished_ == 0 || events_ != events; });
+    }
+  }
+}
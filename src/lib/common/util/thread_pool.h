@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+// a pool of worker threads, each worker has its own task deque:
+// the owner pushes and pops from the back, idle workers steal from the front of other deques
+class ThreadPool {
+public:
+  using Task = std::function<void()>;
+
+  struct Options {
+    // zero means the number of hardware threads
+    size_t thread_count = 0;
+    // pin the i-th worker to the i-th CPU
+    bool pin_threads = false;
+  };
+
+public:
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+
+  explicit ThreadPool(Options options);
+  ThreadPool();
+  ~ThreadPool();
+
+  // the pool with default options shared by the whole process
+  static ThreadPool& shared();
+
+  size_t thread_count() const;
+
+  // the task is pushed to the current worker's deque if called from a worker, otherwise to any deque
+  void submit(Task task, const TaskGroup* group = nullptr);
+
+  // runs one pending task in the current thread, only a task of `group` if it's set; returns false if there are none
+  bool run_pending_task(const TaskGroup* group = nullptr);
+
+  // calls `body(index)` for each index in [begin, end), the calling thread takes part in the work too
+  void parallel_for(size_t begin, size_t end, const std::function<void(size_t)>& body, size_t grain = 1);
+
+private:
+  struct QueuedTask {
+    Task task;
+    const TaskGroup* group;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<QueuedTask> tasks;
+  };
+
+  void worker_loop(size_t index);
+  std::optional<Task> pop_task(size_t index, const TaskGroup* group);
+  std::optional<Task> steal_task(size_t thief_index, const TaskGroup* group);
+
+private:
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  // number of tasks in all deques, may be negative for a moment
+  std::atomic<int64_t> pending_{};
+  std::atomic_size_t next_worker_{};
+
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  bool stop_{};
+};
+
+// a set of tasks that can be waited on, the waiting thread helps to run only the tasks of the group,
+// so it never runs unrelated work nested on its stack, and sleeps if none of them is pending
+class TaskGroup {
+public:
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup(TaskGroup&&) = delete;
+
+  explicit TaskGroup(ThreadPool& pool);
+  ~TaskGroup();
+
+  void run(ThreadPool::Task task);
+  void wait();
+
+private:
+  ThreadPool& pool_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  size_t unfinished_{};
+  // changed when a task is submitted or finished, so the waiter looks for a task to run again
+  uint64_t events_{};
+};
@@ -0,0 +1,300 @@
+#include "instruction.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "lib/common/memory/types.h"
+#include "lib/m68k/registers/registers.h"
+#include "lib/m68k/target/target.h"
+
+namespace m68k {
+
+namespace {
+
+bool is_register(const Target& target) {
+  return target.kind() == Target::DataRegisterKind || target.kind() == Target::AddressRegisterKind;
+}
+
+// effective address calculation time, "68000 User's Manual", table 8-1
+uint32_t ea_cycles(const Target& target, Instruction::Size size) {
+  uint32_t cycles = 0;
+  switch (target.kind()) {
+  case Target::DataRegisterKind:
+  case Target::AddressRegisterKind:
+    return 0;
+  case Target::AddressKind:
+  case Target::AddressIncrementKind:
+  case Target::ImmediateKind:
+    cycles = 4;
+    break;
+  case Target::AddressDecrementKind:
+    cycles = 6;
+    break;
+  case Target::AddressDisplacementKind:
+  case Target::ProgramCounterDisplacementKind:
+  case Target::AbsoluteShortKind:
+    cycles = 8;
+    break;
+  case Target::AddressIndexKind:
+  case Target::ProgramCounterIndexKind:
+    cycles = 10;
+    break;
+  case Target::AbsoluteLongKind:
+    cycles = 12;
+    break;
+  }
+  return cycles + (size == Instruction::LongSize ? 4 : 0);
+}
+
+// the destination of MOVE doesn't pay for the predecrement
+uint32_t move_destination_cycles(const Target& target, Instruction::Size size) {
+  if (target.kind() == Target::AddressDecrementKind) {
+    return size == Instruction::LongSize ? 8 : 4;
+  }
+  return ea_cycles(target, size);
+}
+
+// JMP, JSR, LEA and PEA have a time for every control addressing mode, table 8-11
+uint32_t control_cycles(const Target& target, std::array<uint32_t, 7> cycles) {
+  switch (target.kind()) {
+  case Target::AddressKind:
+    return cycles[0];
+  case Target::AddressDisplacementKind:
+    return cycles[1];
+  case Target::AddressIndexKind:
+    return cycles[2];
+  case Target::AbsoluteShortKind:
+    return cycles[3];
+  case Target::AbsoluteLongKind:
+    return cycles[4];
+  case Target::ProgramCounterDisplacementKind:
+    return cycles[5];
+  case Target::ProgramCounterIndexKind:
+    return cycles[6];
+  default:
+    return cycles[0];
+  }
+}
+
+uint32_t shift_count(const Instruction& inst, const Registers& before) {
+  if (inst.has_src()) {
+    return before.d()[inst.src().index()] % 64;
+  }
+  return inst.data() ? inst.data() : 8;
+}
+
+// the multiplication time depends on the source operand, the average is taken if it's in memory
+uint32_t multiply_bits(const Instruction& inst, const Registers& before) {
+  if (inst.src().kind() != Target::DataRegisterKind) {
+    return 8;
+  }
+  const Word src = before.d()[inst.src().index()];
+  if (inst.kind() == Instruction::MuluKind) {
+    return std::popcount(src);
+  }
+  // the number of 01 and 10 patterns in the source with a zero appended
+  return std::popcount(static_cast<Word>(src ^ (src << 1)));
+}
+
+} // namespace
+
+uint32_t Instruction::cycles(const Registers& before, const Registers& after, AddressType next_pc) const {
+  const bool is_long = size_ == LongSize;
+  const bool jumped = after.pc != next_pc;
+
+  switch (kind_) {
+  case AbcdKind:
+  case SbcdKind:
+    return is_register(src_) ? 6 : 18;
+  case AddxKind:
+  case SubxKind:
+    if (is_register(src_)) {
+      return is_long ? 8 : 4;
+    }
+    return is_long ? 30 : 18;
+  case AddKind:
+  case AndKind:
+  case OrKind:
+  case SubKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      if (is_long) {
+        return (is_register(src_) || src_.kind() == Target::ImmediateKind ? 8 : 6) + ea_cycles(src_, size_);
+      }
+      return 4 + ea_cycles(src_, size_);
+    }
+    return (is_long ? 12 : 8) + ea_cycles(dst_, size_);
+  case EorKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      return is_long ? 8 : 4;
+    }
+    return (is_long ? 12 : 8) + ea_cycles(dst_, size_);
+  case CmpKind:
+    return (is_long ? 6 : 4) + ea_cycles(src_, size_);
+  case AddaKind:
+  case SubaKind:
+    if (is_long) {
+      return (is_register(src_) || src_.kind() == Target::ImmediateKind ? 8 : 6) + ea_cycles(src_, size_);
+    }
+    return 8 + ea_cycles(src_, size_);
+  case CmpaKind:
+    return 6 + ea_cycles(src_, size_);
+  case AddiKind:
+  case AndiKind:
+  case EoriKind:
+  case OriKind:
+  case SubiKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      return is_long ? 16 : 8;
+    }
+    return (is_long ? 20 : 12) + ea_cycles(dst_, size_);
+  case CmpiKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      return is_long ? 14 : 8;
+    }
+    return (is_long ? 12 : 8) + ea_cycles(dst_, size_);
+  case AddqKind:
+  case SubqKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      return is_long ? 8 : 4;
+    }
+    if (dst_.kind() == Target::AddressRegisterKind) {
+      return 8;
+    }
+    return (is_long ? 12 : 8) + ea_cycles(dst_, size_);
+  case AndiToCcrKind:
+  case AndiToSrKind:
+  case EoriToCcrKind:
+  case EoriToSrKind:
+  case OriToCcrKind:
+  case OriToSrKind:
+    return 20;
+  case AslKind:
+  case AsrKind:
+  case LslKind:
+  case LsrKind:
+  case RolKind:
+  case RorKind:
+  case RoxlKind:
+  case RoxrKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      return (is_long ? 8 : 6) + 2 * shift_count(*this, before);
+    }
+    return 8 + ea_cycles(dst_, WordSize);
+  case BccKind:
+    if (jumped) {
+      return 10;
+    }
+    return size_ == ByteSize ? 8 : 12;
+  case BsrKind:
+    return 18;
+  case BchgKind:
+  case BsetKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      return src_.kind() == Target::DataRegisterKind ? 8 : 12;
+    }
+    return (src_.kind() == Target::DataRegisterKind ? 8 : 12) + ea_cycles(dst_, ByteSize);
+  case BclrKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      return src_.kind() == Target::DataRegisterKind ? 10 : 14;
+    }
+    return (src_.kind() == Target::DataRegisterKind ? 8 : 12) + ea_cycles(dst_, ByteSize);
+  case BtstKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      return src_.kind() == Target::DataRegisterKind ? 6 : 10;
+    }
+    return (src_.kind() == Target::DataRegisterKind ? 4 : 8) + ea_cycles(dst_, ByteSize);
+  case ChkKind:
+    return (jumped ? 40 : 10) + ea_cycles(src_, WordSize);
+  case ClrKind:
+  case NegKind:
+  case NegxKind:
+  case NotKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      return is_long ? 6 : 4;
+    }
+    return (is_long ? 12 : 8) + ea_cycles(dst_, size_);
+  case CmpmKind:
+    return is_long ? 20 : 12;
+  case DbccKind: {
+    if (jumped) {
+      return 10;
+    }
+    // the counter is decremented only if the condition is false
+    const bool expired = Word(before.d()[dst_.index()]) != Word(after.d()[dst_.index()]);
+    return expired ? 14 : 12;
+  }
+  case DivsKind:
+    // the worst case, the real time depends on the operands
+    return 158 + ea_cycles(src_, WordSize);
+  case DivuKind:
+    return 140 + ea_cycles(src_, WordSize);
+  case MulsKind:
+  case MuluKind:
+    return 38 + 2 * multiply_bits(*this, before) + ea_cycles(src_, WordSize);
+  case ExgKind:
+    return 6;
+  case ExtKind:
+  case MoveqKind:
+  case NopKind:
+  case SwapKind:
+  case MoveFromUspKind:
+  case MoveToUspKind:
+    return 4;
+  case JmpKind:
+    return control_cycles(dst_, {8, 10, 14, 10, 12, 10, 14});
+  case JsrKind:
+    return control_cycles(dst_, {16, 18, 22, 18, 20, 18, 22});
+  case LeaKind:
+    return control_cycles(src_, {4, 8, 12, 8, 12, 8, 12});
+  case PeaKind:
+    return control_cycles(src_, {12, 16, 20, 16, 20, 16, 20});
+  case LinkKind:
+    return 16;
+  case UnlinkKind:
+    return 12;
+  case MoveFromSrKind:
+    return dst_.kind() == Target::DataRegisterKind ? 6 : 8 + ea_cycles(dst_, WordSize);
+  case MoveToCcrKind:
+  case MoveToSrKind:
+    return 12 + ea_cycles(src_, WordSize);
+  case MoveKind:
+  case MoveaKind:
+    return 4 + ea_cycles(src_, size_) + move_destination_cycles(dst_, size_);
+  case MovemKind: {
+    // the predecrement and postincrement modes take the same time as the plain address mode
+    const uint32_t registers = std::popcount(data_);
+    const uint32_t per_register = is_long ? 8 : 4;
+    const auto& target = has_src_ ? src_ : dst_;
+    const uint32_t ea = target.kind() == Target::AddressDecrementKind ? 0 : ea_cycles(target, WordSize) - 4;
+    return (has_src_ ? 12 : 8) + ea + per_register * registers;
+  }
+  case MovepKind:
+    return is_long ? 24 : 16;
+  case NbcdKind:
+    return dst_.kind() == Target::DataRegisterKind ? 6 : 8 + ea_cycles(dst_, ByteSize);
+  case ResetKind:
+    return 132;
+  case RteKind:
+  case RtrKind:
+    return 20;
+  case RtsKind:
+    return 16;
+  case SccKind:
+    if (dst_.kind() == Target::DataRegisterKind) {
+      return Byte(after.d()[dst_.index()]) == 0xFF ? 6 : 4;
+    }
+    return 8 + ea_cycles(dst_, ByteSize);
+  case TasKind:
+    return dst_.kind() == Target::DataRegisterKind ? 4 : 14 + ea_cycles(dst_, ByteSize);
+  case TrapKind:
+    return 34;
+  case TrapvKind:
+    return jumped ? 34 : 4;
+  case TstKind:
+    return 4 + ea_cycles(src_, size_);
+  }
+  return 4;
+}
+
+} // namespace m68k
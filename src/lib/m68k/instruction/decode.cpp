@@ -1,10 +1,8 @@
-#include "fmt/format.h"
 #include "instruction.h"
 
 #include <array>
 #include <cstddef>
 #include <cstdint>
-#include <fmt/core.h>
 #include <optional>
 #include <string_view>
 #include <tuple>
@@ -93,7 +91,7 @@ std::expected<Instruction, Error> Instruction::decode(Context ctx) {
 
   const auto parse_target_with_size = [&](Size size, std::size_t modeBegin,
                                           std::size_t indexBegin) -> std::expected<Target, Error> {
-    Target target;
+    Target target{};
 
     const auto mode = bits_range(modeBegin, 3);
     const auto xn = bits_range(indexBegin, 3);
@@ -154,7 +152,7 @@ std::expected<Instruction, Error> Instruction::decode(Context ctx) {
       }
       default:
         return std::unexpected<Error>(
-            {Error::UnknownAddressingMode, fmt::format("Unknown addresing mode in word {:04x}", *word)});
+            {Error::UnknownAddressingMode, "Unknown addresing mode in word {:04x}", *word});
       }
       break;
     }
@@ -180,7 +178,7 @@ std::expected<Instruction, Error> Instruction::decode(Context ctx) {
 #define PARSE_TARGET_SAFE PARSE_TARGET_WITH_SIZE_SAFE(get_size0())
 
   // decode the opcode
-  Instruction inst;
+  Instruction inst{};
 
   /*
    * Status register instruction: [ANDI|EORI]to[CCR|SR]
@@ -605,7 +603,7 @@ std::expected<Instruction, Error> Instruction::decode(Context ctx) {
     TRY_PARSE_SAFE(try_parse_binary_instruction);
     TRY_PARSE_SAFE(try_parse_move_instruction);
 
-    return std::unexpected<Error>{{Error::UnknownOpcode, fmt::format("Unknown opcode {:04x}", *word)}};
+    return std::unexpected<Error>{{Error::UnknownOpcode, "Unknown opcode {:04x}", *word}};
   }
 
   return inst;
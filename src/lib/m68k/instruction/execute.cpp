@@ -5,7 +5,6 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <fmt/core.h>
 #include <optional>
 #include <utility>
 
@@ -202,7 +201,7 @@ std::optional<Error> Instruction::execute(Context ctx) {
       }
     }
     if (pc & 1) {
-      return Error{Error::UnalignedProgramCounter, fmt::format("program counter set at {:04x}", pc)};
+      return Error{Error::UnalignedProgramCounter, "program counter set at {:04x}", pc};
     }
     return std::nullopt;
   };
@@ -440,14 +439,14 @@ std::optional<Error> Instruction::execute(Context ctx) {
   case OriToSrKind: {
     SAFE_DECLARE(src_val, src_.read<Word>(ctx));
     // TODO: find out why bits 12 and 14 matter
-    ctx.registers.sr = do_binary_op(opcode_type(kind_), Word{ctx.registers.sr}, *src_val & 0b1010'1111'1111'1111);
+    ctx.registers.set_sr(do_binary_op(opcode_type(kind_), Word{ctx.registers.sr}, *src_val & 0b1010'1111'1111'1111));
     break;
   }
   case MoveToSrKind: {
     SAFE_DECLARE(src_val, src_.read<Word>(ctx));
     try_inc_address_src();
     // TODO: find out why bits 12 and 14 matter
-    ctx.registers.sr = *src_val & 0b1010'1111'1111'1111;
+    ctx.registers.set_sr(*src_val & 0b1010'1111'1111'1111);
     break;
   }
   case MoveFromSrKind: {
@@ -456,11 +455,11 @@ std::optional<Error> Instruction::execute(Context ctx) {
   }
   case MoveToUspKind: {
     SAFE_DECLARE(src_val, src_.read<Long>(ctx));
-    ctx.registers.usp = *src_val;
+    ctx.registers.set_usp(*src_val);
     break;
   }
   case MoveFromUspKind: {
-    SAFE_CALL(dst_.write<Long>(ctx, ctx.registers.usp));
+    SAFE_CALL(dst_.write<Long>(ctx, ctx.registers.usp()));
     break;
   }
   case AslKind:
@@ -593,7 +592,7 @@ std::optional<Error> Instruction::execute(Context ctx) {
       push_stack(old_pc);
     }
     if (ctx.registers.pc & 1) {
-      return Error{Error::UnalignedProgramCounter, fmt::format("program counter set at {:04x}", ctx.registers.pc)};
+      return Error{Error::UnalignedProgramCounter, "program counter set at {:04x}", ctx.registers.pc};
     }
     break;
   }
@@ -804,15 +803,7 @@ std::optional<Error> Instruction::execute(Context ctx) {
   case MovemKind: {
     const auto has_bit = [&](std::size_t i) { return data_ & (1 << i); };
 
-    const auto get_reg = [&](std::size_t i) -> Long& {
-      if (i <= 7) {
-        return ctx.registers.d[i];
-      } else if (i <= 14) {
-        return ctx.registers.a[i - 8];
-      } else {
-        return ctx.registers.stack_ptr();
-      }
-    };
+    const auto get_reg = [&](std::size_t i) -> Long& { return ctx.registers.da[i]; };
 
     if (has_src_) {
       const std::size_t reg_count = std::popcount(data_);
@@ -950,7 +941,7 @@ std::optional<Error> Instruction::execute(Context ctx) {
       break;
     }
 
-    ctx.registers.sr.supervisor = 1;
+    ctx.registers.set_supervisor(true);
     push_stack(ctx.registers.pc);
     push_stack(Word{ctx.registers.sr});
 
@@ -969,13 +960,13 @@ std::optional<Error> Instruction::execute(Context ctx) {
 
     if (kind_ == RteKind) {
       // TODO: find out why bits 12 and 14 matter
-      ctx.registers.sr = newSr & 0b1010'1111'1111'1111;
+      ctx.registers.set_sr(newSr & 0b1010'1111'1111'1111);
     } else if (kind_ == RtrKind) {
       ctx.registers.sr = (ctx.registers.sr & 0xFF00) | (newSr & 0x00FF);
     }
 
     if (ctx.registers.pc & 1) {
-      return Error{Error::UnalignedProgramCounter, fmt::format("program counter set at {:04x}", ctx.registers.pc)};
+      return Error{Error::UnalignedProgramCounter, "program counter set at {:04x}", ctx.registers.pc};
     }
     break;
   }
@@ -993,7 +984,7 @@ std::optional<Error> Instruction::execute(Context ctx) {
     const auto signed_src = static_cast<SignedWord>(*src_val);
     const auto signed_dst = static_cast<SignedWord>(*dst_val);
     if (signed_dst < 0 || signed_dst > signed_src) {
-      ctx.registers.sr.supervisor = 1;
+      ctx.registers.set_supervisor(true);
       push_stack(ctx.registers.pc);
       push_stack(Word{ctx.registers.sr});
 
@@ -1036,7 +1027,7 @@ std::optional<Error> Instruction::execute(Context ctx) {
     SAFE_DECLARE(dst_val, dst_.read<Long>(ctx));
 
     if (*src_val == 0) {
-      ctx.registers.sr.supervisor = 1;
+      ctx.registers.set_supervisor(true);
       push_stack(ctx.registers.pc);
       push_stack(Word{ctx.registers.sr});
 
@@ -0,0 +1,44 @@
+#include "fusion.h"
+
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/target/target.h"
+
+namespace m68k {
+
+namespace {
+
+bool is_increment_or_plain(const Target& target) {
+  return target.kind() == Target::AddressIncrementKind || target.kind() == Target::AddressKind;
+}
+
+} // namespace
+
+Fusion find_fusion(const Instruction& first, const Instruction& second) {
+  switch (first.kind()) {
+  case Instruction::CmpKind:
+  case Instruction::CmpaKind:
+  case Instruction::CmpiKind:
+  case Instruction::TstKind:
+  case Instruction::BtstKind:
+    return second.kind() == Instruction::BccKind ? Fusion::CompareBranch : Fusion::None;
+  case Instruction::MoveKind:
+    if (second.kind() == Instruction::DbccKind && first.src().kind() == Target::AddressIncrementKind &&
+        is_increment_or_plain(first.dst())) {
+      return Fusion::CopyLoop;
+    }
+    if (second.kind() == Instruction::DbccKind && first.src().kind() == Target::DataRegisterKind &&
+        is_increment_or_plain(first.dst())) {
+      return Fusion::FillLoop;
+    }
+    return second.kind() == Instruction::AddqKind ? Fusion::MoveAddq : Fusion::None;
+  case Instruction::ClrKind:
+    if (second.kind() == Instruction::DbccKind && first.dst().kind() == Target::AddressIncrementKind) {
+      return Fusion::FillLoop;
+    }
+    return Fusion::None;
+  default:
+    return Fusion::None;
+  }
+}
+
+} // namespace m68k
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+#include "lib/m68k/instruction/instruction.h"
+
+namespace m68k {
+
+// frequent pairs of instructions that are executed in one dispatch
+enum class Fusion : uint8_t {
+  None,
+  // CMP, CMPA, CMPI, TST or BTST followed by Bcc
+  CompareBranch,
+  // MOVE (An)+,(Am)+ or MOVE (An)+,(Am) followed by DBcc
+  CopyLoop,
+  // MOVE followed by ADDQ
+  MoveAddq,
+  // CLR (An)+, MOVE Dn,(An)+ or MOVE Dn,(An) followed by DBcc
+  FillLoop,
+};
+
+// `second` is the instruction right after `first`
+Fusion find_fusion(const Instruction& first, const Instruction& second);
+
+} // namespace m68k
@@ -7,6 +7,7 @@
 #include "lib/common/error/error.h"
 #include "lib/common/memory/types.h"
 #include "lib/m68k/common/context.h"
+#include "lib/m68k/registers/registers.h"
 #include "lib/m68k/target/target.h"
 
 namespace m68k {
@@ -132,8 +133,37 @@ public:
   Instruction& dst(Target target);
   Instruction& data(Long data);
 
+  // getters
+  Kind kind() const {
+    return kind_;
+  }
+  Size size() const {
+    return size_;
+  }
+  Condition condition() const {
+    return cond_;
+  }
+  const Target& src() const {
+    return src_;
+  }
+  const Target& dst() const {
+    return dst_;
+  }
+  Long data() const {
+    return data_;
+  }
+  bool has_src() const {
+    return has_src_;
+  }
+  bool has_dst() const {
+    return has_dst_;
+  }
+
   [[nodiscard]] std::optional<Error> execute(Context ctx);
 
+  // the 68000 clock cycles of the executed instruction, `next_pc` is the address after it
+  uint32_t cycles(const Registers& before, const Registers& after, AddressType next_pc) const;
+
   // helper methods
   std::string print() const;
 
@@ -0,0 +1,128 @@
+#include "packed_instruction.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "lib/common/memory/types.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/target/target.h"
+
+namespace m68k {
+
+namespace {
+
+std::optional<uint8_t> pack_size(uint8_t size) {
+  switch (size) {
+  case 0:
+  case 1:
+  case 2:
+    return size;
+  case 4:
+    return 3;
+  default:
+    return std::nullopt;
+  }
+}
+
+uint8_t expand_size(uint8_t size) {
+  return size == 3 ? 4 : size;
+}
+
+bool has_relative_data(Instruction::Kind kind) {
+  return kind == Instruction::MoveKind || kind == Instruction::MoveaKind;
+}
+
+} // namespace
+
+std::optional<PackedInstruction> PackedInstruction::pack(const Instruction& inst, AddressType pc,
+                                                         AddressType next_pc) {
+  PackedInstruction packed{};
+  packed.kind_ = inst.kind();
+
+  if (next_pc < pc || next_pc - pc > UINT8_MAX) {
+    return std::nullopt;
+  }
+  packed.length_ = next_pc - pc;
+
+  const Long data = has_relative_data(inst.kind()) ? inst.data() - pc : inst.data();
+  if (data > UINT16_MAX) {
+    return std::nullopt;
+  }
+  packed.data_ = data;
+
+  const auto size = pack_size(inst.size());
+  if (!size) {
+    return std::nullopt;
+  }
+  packed.size_ = *size;
+  packed.cond_ = inst.condition();
+
+  packed.src_kind_ = packed.dst_kind_ = kNoTarget;
+  if (inst.has_src()) {
+    const auto& src = inst.src();
+    const auto src_size = pack_size(src.size());
+    const auto src_ext = pack_ext(src, pc);
+    if (src.index() > 7 || !src_size || !src_ext) {
+      return std::nullopt;
+    }
+    packed.src_kind_ = src.kind();
+    packed.src_index_ = src.index();
+    packed.src_size_ = *src_size;
+    packed.src_ext_ = *src_ext;
+  }
+  if (inst.has_dst()) {
+    const auto& dst = inst.dst();
+    const auto dst_size = pack_size(dst.size());
+    const auto dst_ext = pack_ext(dst, pc);
+    if (dst.index() > 7 || !dst_size || !dst_ext) {
+      return std::nullopt;
+    }
+    packed.dst_kind_ = dst.kind();
+    packed.dst_index_ = dst.index();
+    packed.dst_size_ = *dst_size;
+    packed.dst_ext_ = *dst_ext;
+  }
+
+  return packed;
+}
+
+Instruction PackedInstruction::expand(AddressType pc) const {
+  Instruction inst{};
+  inst.kind(kind_)
+      .size(static_cast<Instruction::Size>(expand_size(size_)))
+      .condition(static_cast<Instruction::Condition>(cond_))
+      .data(has_relative_data(kind_) ? pc + data_ : data_);
+  if (src_kind_ != kNoTarget) {
+    inst.src(expand_target(src_kind_, src_index_, src_size_, src_ext_, pc));
+  }
+  if (dst_kind_ != kNoTarget) {
+    inst.dst(expand_target(dst_kind_, dst_index_, dst_size_, dst_ext_, pc));
+  }
+  return inst;
+}
+
+std::optional<Long> PackedInstruction::pack_ext(const Target& target, AddressType pc) {
+  // only the immediate target has an address, it has no extension words
+  if (target.kind() == Target::ImmediateKind) {
+    if (target.ext_word0() || target.ext_word1()) {
+      return std::nullopt;
+    }
+    return target.address() - pc;
+  }
+  if (target.address()) {
+    return std::nullopt;
+  }
+  return (Long{target.ext_word0()} << 16) | target.ext_word1();
+}
+
+Target PackedInstruction::expand_target(uint8_t kind, uint8_t index, uint8_t size, Long ext, AddressType pc) {
+  auto target = Target{}.kind(static_cast<Target::Kind>(kind)).index(index).size(expand_size(size));
+  if (kind == Target::ImmediateKind) {
+    target.address(pc + ext);
+  } else {
+    target.ext_word0(ext >> 16).ext_word1(ext & 0xFFFF);
+  }
+  return target;
+}
+
+} // namespace m68k
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+#include "lib/common/memory/types.h"
+#include "lib/m68k/instruction/fusion.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/target/target.h"
+
+namespace m68k {
+
+// immutable 16-byte form of a decoded instruction, four of them fit in a cache line;
+// it is expanded into a full Instruction that keeps the per-execution state of the targets
+class PackedInstruction {
+public:
+  // returns nullopt if some field doesn't fit, `pc` and `next_pc` are the bounds of the instruction
+  static std::optional<PackedInstruction> pack(const Instruction& inst, AddressType pc, AddressType next_pc);
+
+  Instruction expand(AddressType pc) const;
+
+  // the instruction length in bytes
+  AddressType length() const {
+    return length_;
+  }
+
+  // the fusion with the next instruction, it isn't a part of the decoded instruction
+  Fusion fusion() const {
+    return static_cast<Fusion>(fusion_);
+  }
+  void set_fusion(Fusion fusion) {
+    fusion_ = static_cast<uint32_t>(fusion);
+  }
+
+private:
+  static constexpr uint8_t kNoTarget = 0xF;
+
+  static std::optional<Long> pack_ext(const Target& target, AddressType pc);
+  static Target expand_target(uint8_t kind, uint8_t index, uint8_t size, Long ext, AddressType pc);
+
+private:
+  Instruction::Kind kind_;
+  uint8_t length_;
+  // the MOVE program counter is relative to `pc`
+  Word data_;
+
+  // sizes are 0, 1, 2 or 4 packed into two bits
+  uint32_t size_ : 2;
+  uint32_t cond_ : 4;
+  uint32_t src_kind_ : 4;
+  uint32_t src_index_ : 3;
+  uint32_t src_size_ : 2;
+  uint32_t dst_kind_ : 4;
+  uint32_t dst_index_ : 3;
+  uint32_t dst_size_ : 2;
+  uint32_t fusion_ : 3;
+
+  // extension words, the immediate address is relative to `pc`
+  Long src_ext_;
+  Long dst_ext_;
+};
+
+static_assert(sizeof(PackedInstruction) == 16);
+static_assert(std::is_trivially_copyable_v<PackedInstruction>);
+
+} // namespace m68k
@@ -0,0 +1,286 @@
+#include "lanes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "lib/common/memory/types.h"
+#include "lib/common/util/unreachable.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/registers/registers.h"
+#include "lib/m68k/target/target.h"
+
+namespace m68k {
+
+namespace {
+
+constexpr Byte kCarry = 1 << 0;
+constexpr Byte kOverflow = 1 << 1;
+constexpr Byte kZero = 1 << 2;
+constexpr Byte kNegative = 1 << 3;
+constexpr Byte kExtend = 1 << 4;
+constexpr Byte kFlags = kCarry | kOverflow | kZero | kNegative | kExtend;
+
+using Row = std::array<Long, LaneRegisters::kMaxLanes>;
+
+Row& row(LaneRegisters& lanes, const Target& target) {
+  return lanes.da[target.kind() == Target::AddressRegisterKind ? 8 + target.index() : target.index()];
+}
+
+bool is_data_register(const Target& target) {
+  return target.kind() == Target::DataRegisterKind;
+}
+
+bool is_register(const Target& target) {
+  return target.kind() == Target::DataRegisterKind || target.kind() == Target::AddressRegisterKind;
+}
+
+LongLong size_mask(Instruction::Size size) {
+  return (LongLong{1} << (size * 8)) - 1;
+}
+
+// the lower bytes of the register are replaced
+Long merge(Long reg, LongLong value, LongLong mask) {
+  return (reg & ~mask) | (value & mask);
+}
+
+// N and Z are set by the value, V and C are cleared, X is kept
+Byte logic_flags(Byte ccr, LongLong value, LongLong mask, LongLong sign) {
+  return (ccr & kExtend) | ((value & sign) ? kNegative : 0) | ((value & mask) == 0 ? kZero : 0);
+}
+
+// the flags of ADD, SUB and CMP, the carry is any bit above the size of the 64-bit result
+Byte arithmetic_flags(Byte ccr, LongLong src, LongLong dst, LongLong result, LongLong mask, LongLong sign,
+                      bool subtract, bool set_extend) {
+  const bool carry = result & ~mask;
+  const bool src_msb = ((src & sign) != 0) ^ subtract;
+  const bool dst_msb = dst & sign;
+  const bool result_msb = result & sign;
+  const bool overflow = (src_msb && dst_msb && !result_msb) || (!src_msb && !dst_msb && result_msb);
+  const Byte extend = set_extend ? (carry ? kExtend : 0) : (ccr & kExtend);
+  return extend | (carry ? kCarry : 0) | (overflow ? kOverflow : 0) | ((result & mask) == 0 ? kZero : 0) |
+         (result_msb ? kNegative : 0);
+}
+
+// ADD, SUB, CMP, ADDQ and SUBQ, `src` is a row or a quick value
+template<typename Source>
+void execute_arithmetic(Instruction::Kind kind, Instruction::Size size, Source src, Row& dst, Byte* ccr,
+                        size_t count) {
+  const auto mask = size_mask(size);
+  const auto sign = (mask >> 1) + 1;
+  const bool subtract = kind == Instruction::SubKind || kind == Instruction::SubqKind || kind == Instruction::CmpKind;
+  const bool compare = kind == Instruction::CmpKind;
+  for (size_t i = 0; i < count; ++i) {
+    const LongLong lhs = src(i) & mask;
+    const LongLong rhs = dst[i] & mask;
+    const LongLong result = subtract ? rhs - lhs : rhs + lhs;
+    if (!compare) {
+      dst[i] = merge(dst[i], result, mask);
+    }
+    ccr[i] = arithmetic_flags(ccr[i], lhs, rhs, result, mask, sign, subtract, /*set_extend=*/!compare);
+  }
+}
+
+// AND, OR and EOR
+template<typename Operation>
+void execute_logic(Instruction::Size size, const Row& src, Row& dst, Byte* ccr, size_t count, Operation operation) {
+  const auto mask = size_mask(size);
+  const auto sign = (mask >> 1) + 1;
+  for (size_t i = 0; i < count; ++i) {
+    const LongLong result = operation(src[i], dst[i]) & mask;
+    dst[i] = merge(dst[i], result, mask);
+    ccr[i] = logic_flags(ccr[i], result, mask, sign);
+  }
+}
+
+} // namespace
+
+void LaneRegisters::load(size_t lane, const Registers& registers) {
+  for (size_t r = 0; r < da.size(); ++r) {
+    da[r][lane] = registers.da[r];
+  }
+  ccr[lane] = Word{registers.sr} & kFlags;
+}
+
+void LaneRegisters::store(size_t lane, Registers& registers) const {
+  for (size_t r = 0; r < da.size(); ++r) {
+    registers.da[r] = da[r][lane];
+  }
+  registers.sr = (Word{registers.sr} & ~Word{kFlags}) | ccr[lane];
+}
+
+bool can_execute_on_lanes(const Instruction& instruction) {
+  switch (instruction.kind()) {
+  case Instruction::MoveqKind:
+  case Instruction::AddqKind:
+  case Instruction::SubqKind:
+  case Instruction::ClrKind:
+  case Instruction::SwapKind:
+  case Instruction::ExtKind:
+    return is_data_register(instruction.dst());
+  case Instruction::TstKind:
+    return is_data_register(instruction.src());
+  case Instruction::MoveKind:
+  case Instruction::AddKind:
+  case Instruction::SubKind:
+  case Instruction::CmpKind:
+  case Instruction::AndKind:
+  case Instruction::OrKind:
+  case Instruction::EorKind:
+    return is_data_register(instruction.src()) && is_data_register(instruction.dst());
+  case Instruction::ExgKind:
+    return is_register(instruction.src()) && is_register(instruction.dst());
+  case Instruction::MoveaKind:
+    return is_register(instruction.src()) && instruction.dst().kind() == Target::AddressRegisterKind;
+  case Instruction::LeaKind:
+    switch (instruction.src().kind()) {
+    case Target::AddressKind:
+    case Target::AddressDisplacementKind:
+    case Target::AbsoluteShortKind:
+    case Target::AbsoluteLongKind:
+      return instruction.dst().kind() == Target::AddressRegisterKind;
+    default:
+      return false;
+    }
+  default:
+    return false;
+  }
+}
+
+void execute_on_lanes(const Instruction& instruction, LaneRegisters& lanes, size_t count) {
+  const auto size = instruction.size();
+  auto* ccr = lanes.ccr.data();
+
+  switch (instruction.kind()) {
+  case Instruction::MoveqKind: {
+    const Long value = static_cast<SignedLong>(static_cast<SignedByte>(instruction.data()));
+    auto& dst = row(lanes, instruction.dst());
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] = value;
+      ccr[i] = logic_flags(ccr[i], value, 0xFFFFFFFF, 0x80000000);
+    }
+    break;
+  }
+  case Instruction::MoveKind: {
+    const auto mask = size_mask(size);
+    const auto sign = (mask >> 1) + 1;
+    const auto& src = row(lanes, instruction.src());
+    auto& dst = row(lanes, instruction.dst());
+    for (size_t i = 0; i < count; ++i) {
+      const LongLong value = src[i] & mask;
+      dst[i] = merge(dst[i], value, mask);
+      ccr[i] = logic_flags(ccr[i], value, mask, sign);
+    }
+    break;
+  }
+  case Instruction::AddKind:
+  case Instruction::SubKind:
+  case Instruction::CmpKind: {
+    const auto& src = row(lanes, instruction.src());
+    execute_arithmetic(instruction.kind(), size, [&src](size_t i) -> LongLong { return src[i]; },
+                       row(lanes, instruction.dst()), ccr, count);
+    break;
+  }
+  case Instruction::AddqKind:
+  case Instruction::SubqKind: {
+    const LongLong quick = instruction.data() ? instruction.data() : 8;
+    execute_arithmetic(instruction.kind(), size, [quick](size_t) { return quick; }, row(lanes, instruction.dst()),
+                       ccr, count);
+    break;
+  }
+  case Instruction::AndKind:
+    execute_logic(size, row(lanes, instruction.src()), row(lanes, instruction.dst()), ccr, count,
+                  [](Long lhs, Long rhs) { return lhs & rhs; });
+    break;
+  case Instruction::OrKind:
+    execute_logic(size, row(lanes, instruction.src()), row(lanes, instruction.dst()), ccr, count,
+                  [](Long lhs, Long rhs) { return lhs | rhs; });
+    break;
+  case Instruction::EorKind:
+    execute_logic(size, row(lanes, instruction.src()), row(lanes, instruction.dst()), ccr, count,
+                  [](Long lhs, Long rhs) { return lhs ^ rhs; });
+    break;
+  case Instruction::TstKind: {
+    const auto mask = size_mask(size);
+    const auto sign = (mask >> 1) + 1;
+    const auto& src = row(lanes, instruction.src());
+    for (size_t i = 0; i < count; ++i) {
+      ccr[i] = logic_flags(ccr[i], src[i], mask, sign);
+    }
+    break;
+  }
+  case Instruction::ClrKind: {
+    const auto mask = size_mask(size);
+    auto& dst = row(lanes, instruction.dst());
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] &= ~mask;
+      ccr[i] = (ccr[i] & kExtend) | kZero;
+    }
+    break;
+  }
+  case Instruction::SwapKind: {
+    auto& dst = row(lanes, instruction.dst());
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] = (dst[i] >> 16) | (dst[i] << 16);
+      ccr[i] = logic_flags(ccr[i], dst[i], 0xFFFFFFFF, 0x80000000);
+    }
+    break;
+  }
+  case Instruction::ExtKind: {
+    const auto mask = size_mask(size);
+    const auto sign = (mask >> 1) + 1;
+    auto& dst = row(lanes, instruction.dst());
+    for (size_t i = 0; i < count; ++i) {
+      const LongLong value = size == Instruction::WordSize ? static_cast<Word>(static_cast<SignedByte>(dst[i]))
+                                                           : static_cast<Long>(static_cast<SignedWord>(dst[i]));
+      dst[i] = merge(dst[i], value, mask);
+      ccr[i] = logic_flags(ccr[i], value, mask, sign);
+    }
+    break;
+  }
+  case Instruction::ExgKind:
+    std::swap_ranges(row(lanes, instruction.src()).begin(), row(lanes, instruction.src()).begin() + count,
+                     row(lanes, instruction.dst()).begin());
+    break;
+  case Instruction::MoveaKind: {
+    const auto& src = row(lanes, instruction.src());
+    auto& dst = row(lanes, instruction.dst());
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] = size == Instruction::WordSize ? static_cast<Long>(static_cast<SignedWord>(src[i])) : src[i];
+    }
+    break;
+  }
+  case Instruction::LeaKind: {
+    const auto& src = instruction.src();
+    auto& dst = row(lanes, instruction.dst());
+    switch (src.kind()) {
+    case Target::AddressKind:
+    case Target::AddressDisplacementKind: {
+      const Long displacement = src.kind() == Target::AddressKind ? 0 : static_cast<SignedWord>(src.ext_word0());
+      const auto& base = row(lanes, Target{}.kind(Target::AddressRegisterKind).index(src.index()));
+      for (size_t i = 0; i < count; ++i) {
+        dst[i] = base[i] + displacement;
+      }
+      break;
+    }
+    case Target::AbsoluteShortKind:
+    case Target::AbsoluteLongKind: {
+      const Long address = src.kind() == Target::AbsoluteShortKind
+                               ? static_cast<SignedWord>(src.ext_word0())
+                               : (Long{src.ext_word0()} << 16) + src.ext_word1();
+      for (size_t i = 0; i < count; ++i) {
+        dst[i] = address;
+      }
+      break;
+    }
+    default:
+      unreachable();
+    }
+    break;
+  }
+  default:
+    unreachable();
+  }
+}
+
+} // namespace m68k
@@ -0,0 +1,33 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "lib/common/memory/types.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/registers/registers.h"
+
+namespace m68k {
+
+// registers of many emulator instances (lanes) in the structure-of-arrays form,
+// so an instruction is executed for all lanes by loops that the compiler vectorizes
+struct LaneRegisters {
+  static constexpr size_t kMaxLanes = 64;
+
+  // D0 - D7 and A0 - A7 as in `Registers::da`
+  alignas(64) std::array<std::array<Long, kMaxLanes>, 16> da;
+  // the lower byte of the status register: carry, overflow, zero, negative and extend flags
+  alignas(64) std::array<Byte, kMaxLanes> ccr;
+
+  void load(size_t lane, const Registers& registers);
+  // the program counter, the upper byte of SR and the inactive stack pointer are not changed
+  void store(size_t lane, Registers& registers) const;
+};
+
+// the instruction reads and writes only registers and doesn't change the program flow
+bool can_execute_on_lanes(const Instruction& instruction);
+
+// executes the instruction for lanes `0` to `count - 1`, the results are the same as of `Instruction::execute`
+void execute_on_lanes(const Instruction& instruction, LaneRegisters& lanes, size_t count);
+
+} // namespace m68k
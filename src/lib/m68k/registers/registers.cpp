@@ -14,11 +14,11 @@ std::string dump(const Registers& r) {
   std::stringstream ss;
   ss << std::hex << std::uppercase;
   for (int i = 0; i < 7; ++i) {
-    ss << "D" << i << " = " << r.d[i] << "\tA" << i << " = " << r.a[i] << "\n";
+    ss << "D" << i << " = " << r.d()[i] << "\tA" << i << " = " << r.a()[i] << "\n";
   }
-  ss << "D7 = " << r.d[7] << "\n";
-  ss << "USP = " << r.usp << "\n";
-  ss << "SSP = " << r.ssp << "\n";
+  ss << "D7 = " << r.d()[7] << "\n";
+  ss << "USP = " << r.usp() << "\n";
+  ss << "SSP = " << r.ssp() << "\n";
   ss << "PC = " << r.pc << "\n";
 
   ss << "SR: ";
@@ -49,11 +49,11 @@ std::string dump_colored(const Registers& r) {
   };
 
   for (int i = 0; i < 7; ++i) {
-    ss << make_reg(fmt::format("D{}", i), r.d[i]) << "\t" << make_reg(fmt::format("A{}", i), r.a[i]) << "\n";
+    ss << make_reg(fmt::format("D{}", i), r.d()[i]) << "\t" << make_reg(fmt::format("A{}", i), r.a()[i]) << "\n";
   }
-  ss << make_reg("D7", r.d[7]) << "\n";
-  ss << make_reg("USP", r.usp) << "\n";
-  ss << make_reg("SSP", r.ssp) << "\n";
+  ss << make_reg("D7", r.d()[7]) << "\n";
+  ss << make_reg("USP", r.usp()) << "\n";
+  ss << make_reg("SSP", r.ssp()) << "\n";
   ss << make_reg("PC", r.pc) << "\n";
   ss << make_reg("SR", Word{r.sr}) << " [" << make_reg("T", r.sr.trace) << " " << make_reg("S", r.sr.supervisor) << " "
      << make_reg("M", r.sr.master_switch) << " " << make_reg("I", r.sr.interrupt_mask) << " "
@@ -2,7 +2,9 @@
 #include <array>
 #include <cstdint>
 #include <fmt/core.h>
+#include <span>
 #include <string>
+#include <utility>
 
 #include "fmt/base.h"
 #include "fmt/format.h"
@@ -12,24 +14,34 @@ namespace m68k {
 
 struct Registers {
   /**
-   * Data registers D0 - D7
+   * Data and address registers D0 - D7, A0 - A7 in one array, as they are numbered in extension words
    */
-  std::array<Long, 8> d;
+  std::array<Long, 16> da;
 
   /**
-   * Address registers A0 - A6
+   * Data registers D0 - D7
    */
-  std::array<Long, 7> a;
+  std::span<Long, 8> d() {
+    return std::span{da}.first<8>();
+  }
+  std::span<const Long, 8> d() const {
+    return std::span{da}.first<8>();
+  }
 
   /**
-   * User stack pointer
+   * Address registers A0 - A7, A7 is the active stack pointer
    */
-  Long usp;
+  std::span<Long, 8> a() {
+    return std::span{da}.last<8>();
+  }
+  std::span<const Long, 8> a() const {
+    return std::span{da}.last<8>();
+  }
 
   /**
-   * Supervisor stack pointer
+   * The inactive stack pointer: supervisor stack pointer in the user mode and vice versa
    */
-  Long ssp;
+  Long inactive_sp;
 
   /**
    * Program counter
@@ -67,10 +79,42 @@ struct Registers {
   static_assert(sizeof(sr) == sizeof(Word));
 
   /**
-   * The stack pointer register depend on the supervisor flag
+   * The stack pointer register of the current mode
    */
   Long& stack_ptr() {
-    return sr.supervisor ? ssp : usp;
+    return a()[7];
+  }
+
+  /**
+   * User and supervisor stack pointers, one of them is A7 and the other one is banked
+   */
+  Long usp() const {
+    return sr.supervisor ? inactive_sp : a()[7];
+  }
+  Long ssp() const {
+    return sr.supervisor ? a()[7] : inactive_sp;
+  }
+  void set_usp(Long value) {
+    (sr.supervisor ? inactive_sp : a()[7]) = value;
+  }
+  void set_ssp(Long value) {
+    (sr.supervisor ? a()[7] : inactive_sp) = value;
+  }
+
+  /**
+   * Status register writes that may change the mode, they swap the stack pointers;
+   * a plain assignment to `sr` doesn't swap them, it's only for the initialization
+   */
+  void set_supervisor(bool supervisor) {
+    if (sr.supervisor != supervisor) {
+      std::swap(a()[7], inactive_sp);
+      sr.supervisor = supervisor;
+    }
+  }
+  void set_sr(Word value) {
+    constexpr Word kSupervisorBit = 1 << 13;
+    set_supervisor(value & kSupervisorBit);
+    sr = value;
   }
 };
 static_assert(sizeof(Registers) == 76);
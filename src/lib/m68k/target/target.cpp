@@ -20,14 +20,6 @@ namespace m68k {
 
 namespace {
 
-Long& a_reg(Registers& r, int index) {
-  if (index < 7) {
-    return r.a[index];
-  } else {
-    return r.sr.supervisor ? r.ssp : r.usp;
-  }
-}
-
 int8_t bits_range(auto value, std::size_t begin, std::size_t len) {
   return (value >> begin) & ((1 << len) - 1);
 }
@@ -95,7 +87,7 @@ void Target::set_inc_or_dec_count(std::size_t count) {
 
 void Target::try_decrement_address(Context ctx, std::size_t count) {
   if (kind_ == AddressDecrementKind && !already_decremented_) {
-    auto& reg = a_reg(ctx.registers, index_);
+    auto& reg = ctx.registers.a()[index_];
 
     // stack pointer should be aligned to a word boundary
     Long diff = size_ * count;
@@ -106,7 +98,7 @@ void Target::try_decrement_address(Context ctx, std::size_t count) {
 
 void Target::try_increment_address(Context ctx, std::size_t count) {
   if (kind_ == AddressIncrementKind) {
-    auto& reg = a_reg(ctx.registers, index_);
+    auto& reg = ctx.registers.a()[index_];
 
     // stack pointer should be aligned to a word boundary
     Long diff = size_ * count;
@@ -119,11 +111,11 @@ Long Target::effective_address(Context ctx) const {
   case AddressKind:
   case AddressIncrementKind:
   case AddressDecrementKind:
-    return a_reg(ctx.registers, index_);
+    return ctx.registers.a()[index_];
   case AddressDisplacementKind:
-    return a_reg(ctx.registers, index_) + static_cast<SignedWord>(ext_word0_);
+    return ctx.registers.a()[index_] + static_cast<SignedWord>(ext_word0_);
   case AddressIndexKind:
-    return indexed_address(ctx, a_reg(ctx.registers, index_));
+    return indexed_address(ctx, ctx.registers.a()[index_]);
   case ProgramCounterDisplacementKind:
     return ctx.registers.pc - 2 + static_cast<SignedWord>(ext_word0_);
   case ProgramCounterIndexKind:
@@ -153,10 +145,10 @@ std::optional<Error> Target::read(Context ctx, MutableDataView data) {
 
   switch (kind_) {
   case DataRegisterKind:
-    read_register(ctx.registers.d[index_]);
+    read_register(ctx.registers.d()[index_]);
     break;
   case AddressRegisterKind:
-    read_register(a_reg(ctx.registers, index_));
+    read_register(ctx.registers.a()[index_]);
     break;
   case AbsoluteLongKind:
   case AbsoluteShortKind:
@@ -215,19 +207,19 @@ std::optional<Error> Target::write(Context ctx, DataView data) {
 
   switch (kind_) {
   case DataRegisterKind:
-    write_register(ctx.registers.d[index_]);
+    write_register(ctx.registers.d()[index_]);
     break;
   case AddressRegisterKind:
-    write_register(a_reg(ctx.registers, index_));
+    write_register(ctx.registers.a()[index_]);
     break;
   case AddressKind:
   case AddressIncrementKind:
   case AddressDecrementKind:
-    return ctx.device.write(a_reg(ctx.registers, index_), data);
+    return ctx.device.write(ctx.registers.a()[index_], data);
   case AddressDisplacementKind:
-    return ctx.device.write(a_reg(ctx.registers, index_) + static_cast<SignedWord>(ext_word0_), data);
+    return ctx.device.write(ctx.registers.a()[index_] + static_cast<SignedWord>(ext_word0_), data);
   case AddressIndexKind:
-    return ctx.device.write(indexed_address(ctx, a_reg(ctx.registers, index_)), data);
+    return ctx.device.write(indexed_address(ctx, ctx.registers.a()[index_]), data);
   case ProgramCounterDisplacementKind:
     return ctx.device.write(ctx.registers.pc - 2 + static_cast<SignedWord>(ext_word0_), data);
   case ProgramCounterIndexKind:
@@ -286,8 +278,8 @@ std::string Target::print() const {
 }
 
 Long Target::indexed_address(Context ctx, Long baseAddress) const {
-  const uint8_t xregNum = bits_range(ext_word0_, 12, 3);
-  const Long xreg = bit_at(ext_word0_, 15) ? a_reg(ctx.registers, xregNum) : ctx.registers.d[xregNum];
+  // bit 15 is D/A and bits 12-14 are the register number, that is the index in D0-D7, A0-A7
+  const Long xreg = ctx.registers.da[(ext_word0_ >> 12) & 0xF];
   const Long size = bit_at(ext_word0_, 11) ? /*Long*/ 4 : /*Word*/ 2;
   const Long scale = scale_value(bits_range(ext_word0_, 9, 2));
   const SignedByte disp = static_cast<SignedByte>(bits_range(ext_word0_, 0, 8));
@@ -50,6 +50,18 @@ public:
   uint8_t index() const {
     return index_;
   }
+  uint8_t size() const {
+    return size_;
+  }
+  Word ext_word0() const {
+    return ext_word0_;
+  }
+  Word ext_word1() const {
+    return ext_word1_;
+  }
+  Long address() const {
+    return address_;
+  }
 
   // read methods
   [[nodiscard]] std::optional<Error> read(Context ctx, MutableDataView data);
@@ -0,0 +1,207 @@
+#include "batch_runner.h"
+#include "lib/common/memory/types.h"
+#include "lib/common/util/hash.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/lanes/lanes.h"
+#include "lib/m68k/registers/registers.h"
+#include "lib/sega/executor/accuracy.h"
+#include "lib/sega/executor/backend.h"
+#include "lib/sega/executor/executor.h"
+#include "lib/sega/executor/timing.h"
+#include "lib/sega/memory/controller_device.h"
+#include "lib/sega/rom_loader/rom_loader.h"
+#include "magic_enum/magic_enum.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace sega {
+
+double BatchReport::fps() const {
+  uint64_t frames = 0;
+  for (const auto& lane : lanes) {
+    frames += lane.frames;
+  }
+  return host_seconds > 0 ? frames / host_seconds : 0;
+}
+
+double BatchReport::mips() const {
+  uint64_t instructions = 0;
+  for (const auto& lane : lanes) {
+    instructions += lane.instructions;
+  }
+  return host_seconds > 0 ? instructions / host_seconds / 1e6 : 0;
+}
+
+double BatchReport::lane_percent() const {
+  const auto instructions = lane_instructions + single_instructions;
+  return instructions > 0 ? 100.0 * lane_instructions / instructions : 0;
+}
+
+BatchRunner::Lane::Lane(const BatchOptions& options)
+    : executor{options.rom_path.string(), Timing::Emulated, Backend::Fast, Accuracy::Fast},
+      video{executor.vdp_device()}, frame_done{false} {}
+
+BatchRunner::BatchRunner(BatchOptions options)
+    : options_{std::move(options)}, rom_{load_rom(options_.rom_path.string())},
+      rom_device_{DataView{reinterpret_cast<const Byte*>(rom_.data()), rom_.size()}} {
+  lanes_.reserve(options_.lanes);
+  for (size_t i = 0; i < options_.lanes; ++i) {
+    lanes_.push_back(std::make_unique<Lane>(options_));
+  }
+  report_.lanes.resize(options_.lanes);
+  for (auto& lane : report_.lanes) {
+    lane.frame_hash = kFnvOffsetBasis;
+  }
+}
+
+bool BatchRunner::run_frame() {
+  if (frames_ >= options_.frames || std::ranges::all_of(report_.lanes, &LaneReport::aborted)) {
+    return false;
+  }
+  for (size_t i = 0; i < lanes_.size(); ++i) {
+    auto& lane = *lanes_[i];
+    lane.frame_done = report_.lanes[i].aborted;
+    const uint8_t buttons = options_.input ? options_.input(i, frames_) : 0;
+    for (const auto button : magic_enum::enum_values<ControllerDevice::Button>()) {
+      lane.executor.controller_device().set_button(button, buttons & (1 << std::to_underlying(button)));
+    }
+  }
+
+  const auto begin = std::chrono::steady_clock::now();
+  std::vector<size_t> group;
+  while (true) {
+    // the lanes with the lowest PC go first, so the lanes behind them catch up
+    std::optional<AddressType> min_pc;
+    group.clear();
+    for (size_t i = 0; i < lanes_.size(); ++i) {
+      if (lanes_[i]->frame_done) {
+        continue;
+      }
+      const auto pc = lanes_[i]->executor.registers().pc;
+      if (!min_pc || pc < *min_pc) {
+        min_pc = pc;
+        group.clear();
+      }
+      if (pc == *min_pc) {
+        group.push_back(i);
+      }
+    }
+    if (group.empty()) {
+      break;
+    }
+    if (run_region(region(*min_pc), group) == 0) {
+      run_single(group);
+    }
+  }
+
+  for (size_t i = 0; i < lanes_.size(); ++i) {
+    auto& report = report_.lanes[i];
+    if (report.aborted) {
+      continue;
+    }
+    report.frame_hash = fnv1a(lanes_[i]->video.update(), report.frame_hash);
+    ++report.frames;
+    report.instructions = lanes_[i]->executor.statistics().instructions;
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  ++frames_;
+  report_.host_seconds += std::chrono::duration<double>(end - begin).count();
+  return true;
+}
+
+BatchReport BatchRunner::run() {
+  while (run_frame()) {
+  }
+  return report_;
+}
+
+const BatchReport& BatchRunner::report() const {
+  return report_;
+}
+
+const Executor& BatchRunner::executor(size_t lane) const {
+  return lanes_[lane]->executor;
+}
+
+const BatchRunner::Region& BatchRunner::region(AddressType pc) {
+  if (const auto it = regions_.find(pc); it != regions_.end()) {
+    return it->second;
+  }
+
+  // the ROM is mapped from the zero address if the cached instructions are used, see `Executor`
+  Region region;
+  if (lanes_.front()->executor.metadata().rom_address.begin.get() == 0) {
+    m68k::Registers registers{};
+    registers.pc = pc;
+    while (region.instructions.size() < kMaxRegionLength && registers.pc < rom_.size()) {
+      auto inst = m68k::Instruction::decode({.registers = registers, .device = rom_device_});
+      if (!inst || !m68k::can_execute_on_lanes(*inst)) {
+        break;
+      }
+      region.instructions.push_back(*inst);
+      region.next_pcs.push_back(registers.pc);
+    }
+  }
+  return regions_.emplace(pc, std::move(region)).first->second;
+}
+
+uint64_t BatchRunner::run_region(const Region& region, const std::vector<size_t>& group) {
+  // all lanes run the same number of instructions, none of them may pass an interrupt
+  uint64_t count = region.instructions.size();
+  for (const auto lane : group) {
+    count = std::min(count, lanes_[lane]->executor.instructions_before_interrupt());
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  for (size_t begin = 0; begin < group.size(); begin += m68k::LaneRegisters::kMaxLanes) {
+    const auto size = std::min(m68k::LaneRegisters::kMaxLanes, group.size() - begin);
+    for (size_t i = 0; i < size; ++i) {
+      lane_registers_.load(i, lanes_[group[begin + i]]->executor.registers());
+    }
+    for (size_t i = 0; i < count; ++i) {
+      m68k::execute_on_lanes(region.instructions[i], lane_registers_, size);
+    }
+    for (size_t i = 0; i < size; ++i) {
+      auto& executor = lanes_[group[begin + i]]->executor;
+      auto registers = executor.registers();
+      lane_registers_.store(i, registers);
+      registers.pc = region.next_pcs[count - 1];
+      executor.advance(registers, count);
+    }
+  }
+  report_.lane_instructions += count * group.size();
+  return count;
+}
+
+void BatchRunner::run_single(const std::vector<size_t>& group) {
+  for (const auto index : group) {
+    auto& lane = *lanes_[index];
+    auto& report = report_.lanes[index];
+    const auto instructions = lane.executor.statistics().instructions;
+    const auto result = lane.executor.execute_current_instruction();
+    report_.single_instructions += lane.executor.statistics().instructions - instructions;
+    if (!result.has_value()) {
+      if (++report.faults >= kMaxFaults) {
+        spdlog::warn("too many faults in lane {}, aborting", index);
+        report.aborted = true;
+        lane.frame_done = true;
+      }
+      continue;
+    }
+    if (result.value() == Executor::Result::VblankInterrupt) {
+      lane.frame_done = true;
+    }
+  }
+}
+
+} // namespace sega
@@ -0,0 +1,98 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/lanes/lanes.h"
+#include "lib/sega/executor/executor.h"
+#include "lib/sega/memory/rom_device.h"
+#include "lib/sega/video/video.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace sega {
+
+struct BatchOptions {
+  std::filesystem::path rom_path;
+  size_t lanes;
+  uint64_t frames;
+  // the buttons of a lane in a frame, bit `i` is the state of `ControllerDevice::Button` with value `i`
+  std::function<uint8_t(size_t lane, uint64_t frame)> input;
+};
+
+struct LaneReport {
+  uint64_t frames;
+  uint64_t instructions;
+  // hash of all rendered frames, equal to the hash of `HeadlessRunner` with the same input
+  uint64_t frame_hash;
+  uint64_t faults;
+  bool aborted;
+};
+
+struct BatchReport {
+  std::vector<LaneReport> lanes;
+  // instructions of all lanes executed by `m68k::execute_on_lanes` and one by one
+  uint64_t lane_instructions;
+  uint64_t single_instructions;
+  double host_seconds;
+
+  double fps() const;
+  double mips() const;
+  // the share of instructions executed on lanes, in percents
+  double lane_percent() const;
+};
+
+// runs many instances of one ROM in the emulated timing of the fast tier,
+// the instances at the same PC run straight-line register-only code together over `m68k::LaneRegisters`,
+// the other instructions run one by one, always on the instances with the lowest PC, so they meet again
+class BatchRunner {
+public:
+  BatchRunner(BatchOptions options);
+
+  // returns false if the run is finished
+  bool run_frame();
+  BatchReport run();
+  const BatchReport& report() const;
+
+  const Executor& executor(size_t lane) const;
+
+private:
+  // register-only instructions from a PC to the first other instruction
+  struct Region {
+    std::vector<m68k::Instruction> instructions;
+    // the PC after each instruction
+    std::vector<AddressType> next_pcs;
+  };
+
+  struct Lane {
+    Lane(const BatchOptions& options);
+
+    Executor executor;
+    Video video;
+    // the lane has reached VBLANK or was aborted
+    bool frame_done;
+  };
+
+  const Region& region(AddressType pc);
+  // returns the number of executed instructions of each lane
+  uint64_t run_region(const Region& region, const std::vector<size_t>& group);
+  void run_single(const std::vector<size_t>& group);
+
+private:
+  static constexpr uint64_t kMaxFaults = 1000;
+  static constexpr size_t kMaxRegionLength = 32;
+
+  const BatchOptions options_;
+  const std::vector<char> rom_;
+  RomDevice rom_device_;
+  std::unordered_map<AddressType, Region> regions_;
+  std::vector<std::unique_ptr<Lane>> lanes_;
+  m68k::LaneRegisters lane_registers_;
+  uint64_t frames_{0};
+  BatchReport report_{};
+};
+
+} // namespace sega
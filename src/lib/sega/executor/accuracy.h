@@ -0,0 +1,15 @@
+#pragma once
+
+namespace sega {
+
+// the executor run loop is instantiated for every tier, the tier is chosen at construction
+enum class Accuracy {
+  // every instruction takes the same time, the VDP doesn't know the beam position
+  Fast,
+
+  // instructions take cycles from the 68000 timing tables, the VDP reports the beam position,
+  // HBLANK interrupts are fired; recompiled blocks aren't used
+  Accurate,
+};
+
+} // namespace sega
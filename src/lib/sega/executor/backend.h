@@ -0,0 +1,13 @@
+#pragma once
+
+namespace sega {
+
+enum class Backend {
+  // every instruction is decoded and executed by the interpreter, the ground truth for other backends
+  Reference,
+
+  // instructions are taken from the decode cache, recompiled blocks are run if they are loaded
+  Fast,
+};
+
+} // namespace sega
@@ -0,0 +1,275 @@
+#include "decode_cache.h"
+#include "lib/common/memory/types.h"
+#include "lib/common/util/hash.h"
+#include "lib/m68k/instruction/fusion.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/instruction/packed_instruction.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <filesystem>
+#include <fmt/core.h>
+#include <mutex>
+#include <span>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+namespace sega {
+
+namespace {
+
+constexpr uint32_t kMagic = 'SGDC';
+constexpr uint32_t kVersion = 5;
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entry_size;
+  uint32_t rom_checksum;
+  uint64_t rom_hash;
+  uint64_t slot_count;
+  uint64_t entry_count;
+  // of the entries, the index is checked by the range of its values
+  uint64_t checksum;
+};
+static_assert(sizeof(FileHeader) == 48);
+
+// the layout of entries is dumped as is
+static_assert(std::is_trivially_copyable_v<DecodeCache::Entry>);
+static_assert(alignof(DecodeCache::Entry) <= 8);
+
+size_t entries_offset(size_t slot_count) {
+  const size_t offset = sizeof(FileHeader) + slot_count * sizeof(uint32_t);
+  return (offset + alignof(DecodeCache::Entry) - 1) / alignof(DecodeCache::Entry) * alignof(DecodeCache::Entry);
+}
+
+uint64_t entries_checksum(const DecodeCache::Entry* entries, size_t count) {
+  return fnv1a({reinterpret_cast<const uint8_t*>(entries), count * sizeof(DecodeCache::Entry)});
+}
+
+// the files are trusted only in a directory of the current user that nobody else can write to
+bool make_private_directory(const std::filesystem::path& directory) {
+  if (mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+    return false;
+  }
+  struct stat st;
+  return lstat(directory.c_str(), &st) == 0 && S_ISDIR(st.st_mode) && st.st_uid == getuid() &&
+         (st.st_mode & (S_IRWXG | S_IRWXO)) == 0;
+}
+
+// the instances of a ROM in one process find about the same instructions, so only the first one saves them
+bool claim_save(const std::filesystem::path& path) {
+  static std::mutex mutex;
+  static std::unordered_set<std::string> saved_paths;
+  std::lock_guard lock{mutex};
+  return saved_paths.insert(path.string()).second;
+}
+
+bool write_all(int fd, const void* data, size_t size) {
+  const auto* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    const auto written = write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+
+} // namespace
+
+DecodeCache::DecodeCache(size_t rom_size, uint16_t rom_checksum, uint64_t rom_hash)
+    : rom_size_{rom_size}, slot_count_{rom_size / 2}, rom_checksum_{rom_checksum}, rom_hash_{rom_hash} {}
+
+DecodeCache::~DecodeCache() {
+  unmap();
+}
+
+bool DecodeCache::insert(AddressType pc, const m68k::Instruction& instruction, AddressType next_pc) {
+  const size_t slot = pc >> 1;
+  if ((pc & 1) || slot >= slot_count_ || next_pc > rom_size_) {
+    return false;
+  }
+  const auto packed = m68k::PackedInstruction::pack(instruction, pc, next_pc);
+  if (!packed) {
+    return false;
+  }
+  if (index_.empty()) {
+    index_.resize(slot_count_);
+  }
+  entries_.push_back(*packed);
+  index_[slot] = entries_.size();
+  return true;
+}
+
+void DecodeCache::fuse() {
+  for (size_t slot = 0; slot < index_.size(); ++slot) {
+    if (!index_[slot]) {
+      continue;
+    }
+    auto& entry = entries_[index_[slot] - 1];
+    const AddressType pc = slot << 1;
+    const AddressType next_pc = pc + entry.length();
+    if (const auto* next = find(next_pc)) {
+      entry.set_fusion(m68k::find_fusion(entry.expand(pc), next->expand(next_pc)));
+    }
+  }
+}
+
+void DecodeCache::load(const std::filesystem::path& path) {
+  if (!make_private_directory(path.parent_path())) {
+    spdlog::warn("decode cache directory {} isn't private, the cache is disabled", path.parent_path().string());
+    return;
+  }
+  path_ = path;
+
+  const int fd = open(path.c_str(), O_RDONLY | O_NOFOLLOW);
+  if (fd < 0) {
+    spdlog::info("no decode cache file {}", path.string());
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+    close(fd);
+    return;
+  }
+  const size_t size = st.st_size;
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    spdlog::warn("can't map decode cache file {}", path.string());
+    return;
+  }
+
+  // the file is ignored if it's made for another ROM or by another version of the emulator
+  const auto& header = *static_cast<const FileHeader*>(mapping);
+  const auto* bytes = static_cast<const Byte*>(mapping);
+  if (header.magic != kMagic || header.version != kVersion || header.entry_size != sizeof(Entry) ||
+      header.rom_checksum != rom_checksum_ || header.rom_hash != rom_hash_ || header.slot_count != slot_count_ ||
+      entries_offset(slot_count_) + header.entry_count * sizeof(Entry) != size) {
+    spdlog::warn("decode cache file {} doesn't fit the ROM", path.string());
+    munmap(mapping, size);
+    return;
+  }
+
+  // a damaged file must not point out of the entries or decode to other instructions
+  const auto* index = reinterpret_cast<const uint32_t*>(bytes + sizeof(FileHeader));
+  const auto* entries = reinterpret_cast<const Entry*>(bytes + entries_offset(slot_count_));
+  const bool index_valid = std::all_of(index, index + slot_count_, [&](uint32_t value) {
+    return value <= header.entry_count;
+  });
+  if (!index_valid || entries_checksum(entries, header.entry_count) != header.checksum) {
+    spdlog::warn("decode cache file {} is damaged", path.string());
+    munmap(mapping, size);
+    return;
+  }
+
+  unmap();
+  mapping_ = mapping;
+  mapping_size_ = size;
+  mapped_index_ = index;
+  mapped_entries_ = entries;
+  mapped_entry_count_ = header.entry_count;
+  spdlog::info("mapped decode cache file {} with {} entries", path.string(), mapped_entry_count_);
+}
+
+void DecodeCache::save() {
+  if (entries_.empty() || path_.empty() || !claim_save(path_)) {
+    return;
+  }
+  fuse();
+
+  // merge mapped and new entries
+  std::vector<uint32_t> index(slot_count_);
+  std::vector<Entry> entries;
+  entries.reserve(mapped_entry_count_ + entries_.size());
+  for (size_t slot = 0; slot < slot_count_; ++slot) {
+    if (mapped_index_ && mapped_index_[slot]) {
+      entries.push_back(mapped_entries_[mapped_index_[slot] - 1]);
+    } else if (index_[slot]) {
+      entries.push_back(entries_[index_[slot] - 1]);
+    } else {
+      continue;
+    }
+    index[slot] = entries.size();
+  }
+
+  const FileHeader header{
+      .magic = kMagic,
+      .version = kVersion,
+      .entry_size = sizeof(Entry),
+      .rom_checksum = rom_checksum_,
+      .rom_hash = rom_hash_,
+      .slot_count = slot_count_,
+      .entry_count = entries.size(),
+      .checksum = entries_checksum(entries.data(), entries.size()),
+  };
+
+  // write to a unique temporary file and rename it, so other instances never see a partial file
+  std::error_code error;
+  auto tmp_name = path_.string() + ".XXXXXX";
+  const int fd = mkstemp(tmp_name.data());
+  if (fd < 0) {
+    spdlog::warn("can't create a temporary file for decode cache file {}", path_.string());
+    return;
+  }
+  const std::filesystem::path tmp_path{tmp_name};
+  const std::vector<char> padding(entries_offset(slot_count_) - sizeof(header) - index.size() * sizeof(uint32_t));
+  const bool written = write_all(fd, &header, sizeof(header)) &&
+                       write_all(fd, index.data(), index.size() * sizeof(uint32_t)) &&
+                       write_all(fd, padding.data(), padding.size()) &&
+                       write_all(fd, entries.data(), entries.size() * sizeof(Entry));
+  close(fd);
+  if (!written) {
+    spdlog::warn("can't write decode cache file {}", tmp_path.string());
+    std::filesystem::remove(tmp_path, error);
+    return;
+  }
+  std::filesystem::rename(tmp_path, path_, error);
+  if (error) {
+    spdlog::warn("can't rename decode cache file {}: {}", tmp_path.string(), error.message());
+    std::filesystem::remove(tmp_path, error);
+    return;
+  }
+  spdlog::info("saved decode cache file {} with {} entries", path_.string(), entries.size());
+}
+
+size_t DecodeCache::size() const {
+  return mapped_entry_count_ + entries_.size();
+}
+
+std::filesystem::path DecodeCache::default_path(uint16_t rom_checksum, uint64_t rom_hash) {
+  std::error_code error;
+  auto directory = std::filesystem::temp_directory_path(error);
+  if (error) {
+    directory = ".";
+  }
+  return directory / fmt::format("segacxx-{}", getuid()) / fmt::format("{:04x}-{:016x}.decode", rom_checksum, rom_hash);
+}
+
+void DecodeCache::unmap() {
+  if (mapping_) {
+    munmap(mapping_, mapping_size_);
+  }
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  mapped_index_ = nullptr;
+  mapped_entries_ = nullptr;
+  mapped_entry_count_ = 0;
+}
+
+} // namespace sega
@@ -0,0 +1,89 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/instruction/packed_instruction.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace sega {
+
+// decoded instructions of the ROM, the ROM never changes so an instruction at an address is decoded once;
+// the cache is kept in a file between runs, the file is memory-mapped and new entries are kept in memory
+class DecodeCache {
+public:
+  // the next program counter is the entry address plus its length
+  using Entry = m68k::PackedInstruction;
+
+public:
+  DecodeCache(const DecodeCache&) = delete;
+  DecodeCache(DecodeCache&&) = delete;
+
+  DecodeCache(size_t rom_size, uint16_t rom_checksum, uint64_t rom_hash);
+  ~DecodeCache();
+
+  const Entry* find(AddressType pc) const {
+    const size_t slot = pc >> 1;
+    if ((pc & 1) || slot >= slot_count_) {
+      return nullptr;
+    }
+    if (mapped_index_) {
+      if (const auto index = mapped_index_[slot]) {
+        return &mapped_entries_[index - 1];
+      }
+    }
+    if (!index_.empty()) {
+      if (const auto index = index_[slot]) {
+        return &entries_[index - 1];
+      }
+    }
+    return nullptr;
+  }
+
+  // returns false if the instruction can't be cached, i.e. it's not fully in the ROM or can't be packed
+  bool insert(AddressType pc, const m68k::Instruction& instruction, AddressType next_pc);
+
+  // marks new entries that are fused with the next cached instruction
+  void fuse();
+
+  // maps the cache file if it exists, fits the ROM and isn't damaged; the cache isn't kept in a file at all
+  // if its directory can't be made private to the current user
+  void load(const std::filesystem::path& path);
+  // fuses and writes both mapped and new entries, does nothing if there are no new entries
+  // or if the file was already saved by this process
+  void save();
+
+  // whether the entries were mapped from a file, the file has the code walked by the run that saved it
+  bool mapped() const {
+    return mapping_ != nullptr;
+  }
+  size_t size() const;
+
+  // the file path in a per-user directory of the temporary directory, unique for a ROM
+  static std::filesystem::path default_path(uint16_t rom_checksum, uint64_t rom_hash);
+
+private:
+  void unmap();
+
+private:
+  const size_t rom_size_;
+  const size_t slot_count_;
+  const uint16_t rom_checksum_;
+  const uint64_t rom_hash_;
+  std::filesystem::path path_;
+
+  // memory-mapped entries from the file
+  void* mapping_{};
+  size_t mapping_size_{};
+  const uint32_t* mapped_index_{};
+  const Entry* mapped_entries_{};
+  size_t mapped_entry_count_{};
+
+  // new entries, the index is allocated on the first insertion;
+  // index values are an entry position plus one, zero means no entry
+  std::vector<uint32_t> index_;
+  std::vector<Entry> entries_;
+};
+
+} // namespace sega
@@ -2,8 +2,18 @@
 #include "interrupt_handler.h"
 #include "lib/common/error/error.h"
 #include "lib/common/memory/types.h"
+#include "lib/common/util/hash.h"
+#include "lib/common/util/thread_pool.h"
+#include "lib/m68k/instruction/fusion.h"
 #include "lib/m68k/instruction/instruction.h"
 #include "lib/m68k/registers/registers.h"
+#include "lib/sega/executor/accuracy.h"
+#include "lib/sega/executor/backend.h"
+#include "lib/sega/executor/decode_cache.h"
+#include "lib/sega/executor/idle_loop_detector.h"
+#include "lib/sega/executor/inline_cache_table.h"
+#include "lib/sega/executor/loop_accelerator.h"
+#include "lib/sega/executor/timing.h"
 #include "lib/sega/memory/bus_device.h"
 #include "lib/sega/memory/controller_device.h"
 #include "lib/sega/memory/m68k_ram_device.h"
@@ -14,26 +24,70 @@
 #include "lib/sega/memory/vdp_device.h"
 #include "lib/sega/memory/ym2612_device.h"
 #include "lib/sega/memory/z80_device.h"
+#include "lib/sega/recompiler/code_map.h"
+#include "lib/sega/recompiler/code_walker.h"
+#include "lib/sega/recompiler/recompiled_block.h"
+#include "lib/sega/recompiler/recompiled_code.h"
 #include "lib/sega/rom_loader/rom_loader.h"
 #include "lib/sega/state_dump/state_dump.h"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <spdlog/spdlog.h>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
 namespace sega {
 
+namespace {
+
+// compile-time switches of the run loop
+struct FastPolicy {
+  static constexpr bool kExactCycles = false;
+  static constexpr bool kTrackBeam = false;
+  static constexpr bool kFuseInstructions = true;
+};
+
+struct AccuratePolicy {
+  static constexpr bool kExactCycles = true;
+  static constexpr bool kTrackBeam = true;
+  static constexpr bool kFuseInstructions = false;
+};
+
+// the decode cache, the inline caches, recompiled blocks and idle loop skipping exist only in the fast backend
+template<typename AccuracyPolicy, Backend kBackend>
+struct BackendPolicy : AccuracyPolicy {
+  static constexpr bool kFastBackend = kBackend == Backend::Fast;
+};
+
+// H counter values in a line
+constexpr uint64_t kHorizontalPositions = 210;
+
+} // namespace
+
 class Executor::Impl {
 public:
   Impl(const Impl&) = delete;
   Impl(Impl&&) = delete;
 
-  Impl(std::string_view rom_path)
-      : rom_{load_rom(rom_path)}, rom_device_{DataView{reinterpret_cast<const Byte*>(rom_.data()), rom_.size()}},
-        vdp_device_{bus_}, interrupt_handler_{vector_table().vblank_pc.get(), registers_, bus_, vdp_device_},
+  Impl(std::string_view rom_path, Timing timing, Backend backend, bool constant_vdp_status)
+      : timing_{timing}, backend_{backend}, constant_vdp_status_{constant_vdp_status}, rom_{load_rom(rom_path)},
+        rom_hash_{fnv1a({reinterpret_cast<const uint8_t*>(rom_.data()), rom_.size()})},
+        decode_cache_{decode_cache_size(), metadata().checksum.get(), rom_hash_},
+        inline_caches_{backend == Backend::Fast ? decode_cache_size() : 0},
+        rom_device_{DataView{reinterpret_cast<const Byte*>(rom_.data()), rom_.size()}},
+        ym2612_device_{statistics_.cycles}, vdp_device_{bus_}, psg_device_{statistics_.cycles},
+        loop_accelerator_{DataView{reinterpret_cast<const Byte*>(rom_.data()), rom_.size()}, m68k_ram_device_, bus_},
+        interrupt_handler_{timing, vector_table().vblank_pc.get(), vector_table().hblank_pc.get(), registers_, bus_,
+                           vdp_device_},
         state_dump_{vdp_device_} {
     spdlog::info("loaded ROM file {}", rom_path);
 
@@ -48,34 +102,46 @@ public:
     bus_.add_device(&sram_access_register_device_);
     bus_.add_device(&vdp_device_);
     bus_.add_device(&psg_device_);
-    bus_.add_device(&m68k_ram_device_);
+    bus_.add_memory({M68kRamDevice::kBegin, M68kRamDevice::kEnd}, &m68k_ram_device_, m68k_ram_device_.data());
 
     // make registers
     std::memset(&registers_, 0, sizeof(registers_));
-    registers_.usp = vector_table().reset_sp.get();
+    registers_.set_usp(vector_table().reset_sp.get());
     registers_.pc = vector_table().reset_pc.get();
-  }
 
-  [[nodiscard]] std::expected<Executor::Result, Error> execute_single_instruction() {
-    // check if interrupt happened
-    auto interrupt_check = interrupt_handler_.check();
-    if (!interrupt_check.has_value()) {
-      spdlog::error("interrupt error");
-      return std::unexpected{std::move(interrupt_check.error())};
-    }
-    if (interrupt_check.value()) {
-      return Executor::Result::VblankInterrupt;
+    // reuse instructions decoded by previous runs
+    if (backend_ == Backend::Fast) {
+      decode_cache_.load(DecodeCache::default_path(metadata().checksum.get(), rom_hash_));
+      if (!decode_cache_.mapped()) {
+        discover_code();
+      }
+      decode_cache_.fuse();
+      inline_caches_.reserve(decode_cache_.size());
     }
 
-    // decode and execute the current instruction
-    const auto begin_pc = registers_.pc;
-    auto inst = m68k::Instruction::decode({.registers = registers_, .device = bus_});
-    assert(inst);
-    if (auto err = inst->execute({.registers = registers_, .device = bus_})) {
-      spdlog::error("execute error pc: {:06x} what: {}", begin_pc, err->what());
-      return std::unexpected{std::move(*err)};
+    make_idle_loop_detector();
+    save(power_on_);
+  }
+
+  virtual ~Impl() {
+    decode_cache_.save();
+  }
+
+  // runs up to `count` dispatches, stops after an error or VBLANK
+  [[nodiscard]] virtual std::expected<Executor::Result, Error> execute_instructions(uint64_t count) = 0;
+
+  bool load_recompiled_code(std::string_view path) {
+    if (backend_ == Backend::Reference) {
+      spdlog::warn("recompiled code isn't used by the reference backend");
+      return false;
     }
-    return Executor::Result::Executed;
+    if (!recompiled_code_.load(path, rom_hash_)) {
+      return false;
+    }
+    const auto removed = recompiled_code_.remove_blocks_if(
+        [this](const RecompiledBlock& block) { return !runs_as_recompiled_block(block); });
+    spdlog::info("left {} recompiled blocks with fused pairs or idle loops to the interpreter", removed);
+    return true;
   }
 
   void set_game_speed(double game_speed) {
@@ -86,19 +152,52 @@ public:
     interrupt_handler_.reset_time();
   }
 
-  Executor::InstructionInfo current_instruction_info() {
-    // print current instruction, therefore double-fetching it, so need to restore PC
-    const auto begin_pc = registers_.pc;
+  Executor::InstructionInfo instruction_info(AddressType pc) {
+    // print the instruction, therefore double-fetching it, so need to restore PC
+    const auto current_pc = registers_.pc;
+    registers_.pc = pc;
     auto inst = m68k::Instruction::decode({.registers = registers_, .device = bus_});
-    assert(inst);
     const auto end_pc = registers_.pc;
-    registers_.pc = begin_pc;
+    registers_.pc = current_pc;
+    if (!inst) {
+      return {.pc = pc, .bytes = {}, .description = std::string{inst.error().what()}};
+    }
 
-    return {.pc = begin_pc,
-            .bytes = DataView{reinterpret_cast<const Byte*>(rom_.data() + begin_pc), end_pc - begin_pc},
+    return {.pc = pc,
+            .bytes = DataView{reinterpret_cast<const Byte*>(rom_.data() + pc), end_pc - pc},
             .description = inst->print()};
   }
 
+  void set_write_log(std::vector<BusDevice::Write>* write_log) {
+    bus_.set_write_log(write_log);
+  }
+
+  void set_sound_log(SoundLog* sound_log) {
+    sound_log_ = sound_log;
+    ym2612_device_.set_sound_log(sound_log);
+    psg_device_.set_sound_log(sound_log);
+  }
+
+  void set_idle_loop_skipping(bool enabled) {
+    if (!enabled) {
+      idle_loop_detector_.reset();
+    } else if (!idle_loop_detector_) {
+      make_idle_loop_detector();
+    }
+  }
+
+  virtual uint64_t instructions_before_interrupt() const = 0;
+
+  void count_fault() {
+    ++statistics_.faults;
+  }
+
+  void advance(const m68k::Registers& registers, uint64_t instructions) {
+    registers_ = registers;
+    statistics_.instructions += instructions;
+    statistics_.cycles += instructions * kApproximateInstructionCycles;
+  }
+
   ControllerDevice& controller_device() {
     return controller_device_;
   }
@@ -119,6 +218,73 @@ public:
     return registers_;
   }
 
+  // the code is walked on the first call if the walk was skipped
+  const CodeMap& code_map() const {
+    if (!code_map_) {
+      CodeWalker walker{rom_view(), ThreadPool::shared()};
+      walker.add_vector_table_entry_points();
+      walker.walk();
+      code_map_ = walker.code_map();
+    }
+    return *code_map_;
+  }
+
+  const Executor::Statistics& statistics() const {
+    return statistics_;
+  }
+
+  void save(Executor::Snapshot& snapshot) const {
+    snapshot.registers = registers_;
+    const auto m68k_ram = std::as_const(m68k_ram_device_).data();
+    snapshot.m68k_ram.assign(m68k_ram.begin(), m68k_ram.end());
+    z80_ram_device_.save_state(snapshot.z80_ram);
+    z80_controller_device_.save_state(snapshot.z80_controller);
+    controller_device_.save_state(snapshot.controller);
+    vdp_device_.save_state(snapshot.vdp);
+    ym2612_device_.save_state(snapshot.ym2612);
+    interrupt_handler_.save_state(snapshot.interrupt_handler);
+    snapshot.cycles = statistics_.cycles;
+    snapshot.line = line_;
+    snapshot.frame_idle_skips = frame_idle_skips_;
+    snapshot.waits_for_vblank = waits_for_vblank_;
+  }
+
+  void reset_to(const Executor::Snapshot& snapshot) {
+    // the snapshot must be passed to `save` first, the devices check their own buffers
+    assert(snapshot.m68k_ram.size() == m68k_ram_device_.data().size());
+    registers_ = snapshot.registers;
+    std::memcpy(m68k_ram_device_.data().data(), snapshot.m68k_ram.data(), snapshot.m68k_ram.size());
+    z80_ram_device_.load_state(snapshot.z80_ram);
+    z80_controller_device_.load_state(snapshot.z80_controller);
+    controller_device_.load_state(snapshot.controller);
+    vdp_device_.load_state(snapshot.vdp);
+    ym2612_device_.load_state(snapshot.ym2612);
+    interrupt_handler_.load_state(snapshot.interrupt_handler);
+    // the modular sum is exact if the time goes forward too
+    statistics_.rewound_cycles += statistics_.cycles - snapshot.cycles;
+    statistics_.cycles = snapshot.cycles;
+    line_ = snapshot.line;
+    frame_idle_skips_ = snapshot.frame_idle_skips;
+    waits_for_vblank_ = snapshot.waits_for_vblank;
+    if (sound_log_) {
+      sound_log_->reset(statistics_.cycles);
+    }
+
+    // the time may go back, so the skipped iterations must be seen again
+    if (idle_loop_detector_) {
+      idle_loop_detector_->forget_iteration();
+    }
+  }
+
+  void reset() {
+    reset_to(power_on_);
+  }
+
+  uint16_t beam_line() const {
+    return static_cast<uint16_t>((kVisibleLines + statistics_.cycles % kCyclesPerFrame / kCyclesPerLine) %
+                                 kLinesPerFrame);
+  }
+
   void save_dump_to_file(std::string_view path) const {
     state_dump_.save_dump_to_file(path);
   }
@@ -127,14 +293,343 @@ public:
     state_dump_.apply_dump_from_file(path);
   }
 
+protected:
+  // the run loop, `Policy` removes the work of the accurate tier from the fast tier at compile time
+  template<typename Policy>
+  std::expected<Executor::Result, Error> run_instruction() {
+    if constexpr (Policy::kTrackBeam) {
+      if (auto err = update_beam()) {
+        spdlog::error("HBLANK interrupt error");
+        return std::unexpected{std::move(*err)};
+      }
+    }
+
+    // check if interrupt happened
+    auto interrupt_check = interrupt_handler_.check(statistics_.cycles);
+    if (!interrupt_check.has_value()) {
+      spdlog::error("interrupt error");
+      return std::unexpected{std::move(interrupt_check.error())};
+    }
+    if (interrupt_check.value()) {
+      ++statistics_.frames;
+      count_lag_frame();
+      return Executor::Result::VblankInterrupt;
+    }
+
+    // run the recompiled basic block if there is one and it ends before the next interrupt check,
+    // it reports only the number of executed instructions
+    const auto begin_pc = registers_.pc;
+    if constexpr (Policy::kFastBackend && !Policy::kExactCycles) {
+      if (const auto* block = recompiled_code_.find(begin_pc); block && fits_before_interrupt<Policy>(*block)) {
+        uint32_t executed = 0;
+        auto err = block->function({.registers = registers_, .device = bus_}, executed);
+        statistics_.instructions += executed;
+        statistics_.cycles += executed * kApproximateInstructionCycles;
+        if (err) {
+          spdlog::error("recompiled block error pc: {:06x} what: {}", begin_pc, err->what());
+          return std::unexpected{std::move(*err)};
+        }
+        return Executor::Result::Executed;
+      }
+    }
+
+    const auto begin_cycles = statistics_.cycles;
+    ++statistics_.instructions;
+    auto fusion = m68k::Fusion::None;
+    auto inst = fetch_instruction<Policy>(begin_pc, fusion);
+    if (!inst) {
+      statistics_.cycles += kApproximateInstructionCycles;
+      spdlog::error("decode error pc: {:06x} what: {}", begin_pc, inst.error().what());
+      return std::unexpected{std::move(inst.error())};
+    }
+
+    // execute the current instruction
+    std::optional<Error> err;
+    if constexpr (Policy::kExactCycles) {
+      const auto before = registers_;
+      const auto next_pc = registers_.pc;
+      err = execute<Policy>(*inst, begin_pc);
+      statistics_.cycles += err ? kApproximateInstructionCycles : inst->cycles(before, registers_, next_pc);
+    } else {
+      err = execute<Policy>(*inst, begin_pc);
+      statistics_.cycles += kApproximateInstructionCycles;
+    }
+    if (err) {
+      spdlog::error("execute error pc: {:06x} what: {}", begin_pc, err->what());
+      return std::unexpected{std::move(*err)};
+    }
+
+    // a taken backward branch may close an idle loop
+    if constexpr (Policy::kFastBackend) {
+      if (inst->kind() == m68k::Instruction::BccKind && registers_.pc < begin_pc) {
+        skip_idle_loop<Policy>(begin_pc, begin_cycles);
+      }
+    }
+
+    if constexpr (Policy::kFastBackend && Policy::kFuseInstructions) {
+      if (fusion != m68k::Fusion::None) {
+        return run_fused<Policy>(fusion, *inst, begin_pc);
+      }
+    }
+    return Executor::Result::Executed;
+  }
+
+  // interrupts are checked before every instruction, the next one fires when the time reaches the next frame
+  template<typename Policy>
+  uint64_t count_instructions_before_interrupt() const {
+    const auto next_frame_cycles = interrupt_handler_.next_frame_cycles();
+    if (Policy::kExactCycles || Policy::kTrackBeam || next_frame_cycles == std::numeric_limits<uint64_t>::max() ||
+        interrupt_handler_.due(statistics_.cycles)) {
+      return 0;
+    }
+    return (next_frame_cycles - statistics_.cycles + kApproximateInstructionCycles - 1) /
+           kApproximateInstructionCycles;
+  }
+
 private:
+  // the real time interrupts don't depend on the emulated time, they just come a few instructions later
+  template<typename Policy>
+  bool fits_before_interrupt(const RecompiledBlock& block) const {
+    return timing_ == Timing::RealTime || block.instruction_count <= count_instructions_before_interrupt<Policy>();
+  }
+
+  // the interpreter fuses pairs, accelerates loops and skips idle loops, a block would do none of it;
+  // blocks with instructions missing in the decode cache are left to the interpreter too
+  bool runs_as_recompiled_block(const RecompiledBlock& block) const {
+    auto pc = block.pc;
+    for (uint32_t i = 0; i < block.instruction_count; ++i) {
+      const auto* entry = decode_cache_.find(pc);
+      if (!entry || entry->fusion() != m68k::Fusion::None) {
+        return false;
+      }
+      if (timing_ == Timing::Emulated && is_backward_branch(entry->expand(pc))) {
+        return false;
+      }
+      pc += entry->length();
+    }
+    return true;
+  }
+
+  static bool is_backward_branch(const m68k::Instruction& inst) {
+    if (inst.kind() != m68k::Instruction::BccKind) {
+      return false;
+    }
+    // the displacement is relative to the address after the opcode word
+    const auto displacement = inst.size() == m68k::Instruction::ByteSize ? static_cast<SignedByte>(inst.data())
+                                                                         : static_cast<SignedWord>(inst.data());
+    return displacement + 2 < 0;
+  }
+
+  // runs the second instruction of a fused pair in the same dispatch, unless an interrupt comes before it
+  template<typename Policy>
+  std::expected<Executor::Result, Error> run_fused(m68k::Fusion fusion, const m68k::Instruction& first,
+                                                   AddressType first_pc) {
+    if (interrupt_handler_.due(statistics_.cycles)) {
+      return Executor::Result::Executed;
+    }
+
+    // the next instruction is cached if the pair is fused, unless the first one didn't fall through to it
+    // (e.g. it raised an exception), then the next instruction is fetched as usual
+    const auto begin_pc = registers_.pc;
+    const auto begin_cycles = statistics_.cycles;
+    const auto* entry = decode_cache_.find(begin_pc);
+    if (!entry) {
+      return Executor::Result::Executed;
+    }
+    auto inst = entry->expand(begin_pc);
+    registers_.pc = begin_pc + entry->length();
+
+    ++statistics_.instructions;
+    ++statistics_.fused[std::to_underlying(fusion)];
+    statistics_.cycles += kApproximateInstructionCycles;
+    if (auto err = execute<Policy>(inst, begin_pc)) {
+      spdlog::error("execute error pc: {:06x} what: {}", begin_pc, err->what());
+      return std::unexpected{std::move(*err)};
+    }
+
+    if (inst.kind() == m68k::Instruction::BccKind && registers_.pc < begin_pc) {
+      skip_idle_loop<Policy>(begin_pc, begin_cycles);
+    }
+    if ((fusion == m68k::Fusion::CopyLoop || fusion == m68k::Fusion::FillLoop) && registers_.pc == first_pc) {
+      return run_loop(fusion, first, inst, begin_pc + entry->length());
+    }
+    return Executor::Result::Executed;
+  }
+
+  // runs the rest of a copy or fill loop at once, as many iterations as end before the next frame;
+  // the real time interrupts may come at any moment, so there the loop runs at most for a frame at once
+  std::expected<Executor::Result, Error> run_loop(m68k::Fusion fusion, const m68k::Instruction& body,
+                                                  const m68k::Instruction& dbcc, AddressType exit_pc) {
+    constexpr uint64_t kIterationCycles = 2 * kApproximateInstructionCycles;
+    const auto next_frame_cycles =
+        std::min(interrupt_handler_.next_frame_cycles(), statistics_.cycles + kCyclesPerFrame);
+    const auto max_iterations =
+        next_frame_cycles > statistics_.cycles ? (next_frame_cycles - statistics_.cycles) / kIterationCycles : 0;
+
+    auto iterations = loop_accelerator_.run(body, dbcc, exit_pc, registers_, max_iterations);
+    if (!iterations) {
+      spdlog::error("loop error pc: {:06x} what: {}", registers_.pc, iterations.error().what());
+      return std::unexpected{std::move(iterations.error())};
+    }
+    statistics_.instructions += 2 * *iterations;
+    statistics_.cycles += kIterationCycles * *iterations;
+    statistics_.fused[std::to_underlying(fusion)] += *iterations;
+    return Executor::Result::Executed;
+  }
+
+  // the bus devices accessed by the instruction are resolved through its inline cache in the fast backend,
+  // only the ROM instructions have caches
+  template<typename Policy>
+  std::optional<Error> execute(m68k::Instruction& inst, AddressType pc) {
+    if constexpr (Policy::kFastBackend) {
+      if (pc < decode_cache_size()) {
+        if (auto* inline_cache = inline_caches_.find_or_insert(pc)) {
+          bus_.set_inline_cache(inline_cache);
+          auto err = inst.execute({.registers = registers_, .device = bus_});
+          bus_.set_inline_cache(nullptr);
+          return err;
+        }
+      }
+    }
+    return inst.execute({.registers = registers_, .device = bus_});
+  }
+
+  // the fast backend decodes instructions in the ROM only once, `fusion` is set for cached instructions
+  template<typename Policy>
+  std::expected<m68k::Instruction, Error> fetch_instruction(AddressType pc, m68k::Fusion& fusion) {
+    if constexpr (Policy::kFastBackend) {
+      if (const auto* entry = decode_cache_.find(pc)) {
+        fusion = entry->fusion();
+        registers_.pc = pc + entry->length();
+        return entry->expand(pc);
+      }
+      auto decoded = m68k::Instruction::decode({.registers = registers_, .device = bus_});
+      if (decoded) {
+        decode_cache_.insert(pc, *decoded, registers_.pc);
+      }
+      return decoded;
+    } else {
+      return m68k::Instruction::decode({.registers = registers_, .device = bus_});
+    }
+  }
+
+  // jumps to the last iteration of an idle loop before the next interrupt check,
+  // `checked_cycles` is the time of the last check, i.e. before the branch;
+  // there is no detector in the real time, without the decode cache or if skipping is disabled
+  template<typename Policy>
+  void skip_idle_loop(AddressType branch_pc, uint64_t checked_cycles) {
+    if (!idle_loop_detector_) {
+      return;
+    }
+
+    // interrupts are checked on every line if the beam is tracked, otherwise on every frame
+    constexpr uint64_t kEventCycles = Policy::kTrackBeam ? kCyclesPerLine : kCyclesPerFrame;
+    const auto skip = idle_loop_detector_->on_backward_branch(branch_pc, registers_,
+                                                              {
+                                                                  .cycles = statistics_.cycles,
+                                                                  .instructions = statistics_.instructions,
+                                                                  .bus_writes = bus_.write_count(),
+                                                              },
+                                                              (checked_cycles / kEventCycles + 1) * kEventCycles);
+    if (skip) {
+      statistics_.cycles += skip->cycles;
+      statistics_.instructions += skip->instructions;
+      ++statistics_.idle_skips;
+      statistics_.idle_cycles += skip->cycles;
+    }
+  }
+
+  // the wait tells it better, e.g. the games read the controller in the VBLANK handler or not at all on some screens,
+  // but the idle loops are seen only if they are skipped
+  void count_lag_frame() {
+    const bool polled = controller_device_.take_polled();
+    const bool waited = statistics_.idle_skips != frame_idle_skips_;
+    waits_for_vblank_ |= waited;
+    if (waits_for_vblank_ ? !waited : !polled) {
+      ++statistics_.lag_frames;
+    }
+    frame_idle_skips_ = statistics_.idle_skips;
+  }
+
+  // the beam position follows the emulated time, a frame starts with VBLANK
+  std::optional<Error> update_beam() {
+    const auto frame_cycles = statistics_.cycles % kCyclesPerFrame;
+    const auto line = beam_line();
+
+    // H40 mode: the H counter jumps from B6 to E4, the NTSC V counter jumps from EA to E5
+    const auto h_position = frame_cycles % kCyclesPerLine * kHorizontalPositions / kCyclesPerLine;
+    vdp_device_.set_beam({
+        .v_counter = static_cast<Byte>(line <= 0xEA ? line : line - 6),
+        .h_counter = static_cast<Byte>(h_position <= 0xB6 ? h_position : h_position + (0xE4 - 0xB7)),
+        .in_vblank = line >= kVisibleLines,
+        .in_hblank = h_position > 0xB6,
+    });
+
+    if (line == line_) {
+      return std::nullopt;
+    }
+    line_ = line;
+    return interrupt_handler_.check_line(line);
+  }
+
   const Header& rom_header() const {
     return *reinterpret_cast<const Header*>(rom_.data());
   }
 
+  DataView rom_view() const {
+    return DataView{reinterpret_cast<const Byte*>(rom_.data()), rom_.size()};
+  }
+
+  // the real time interrupts don't depend on the emulated time, so it can't be skipped
+  void make_idle_loop_detector() {
+    if (timing_ == Timing::Emulated && backend_ == Backend::Fast && decode_cache_size() > 0) {
+      idle_loop_detector_.emplace(decode_cache_, rom_.size(), constant_vdp_status_);
+    }
+  }
+
+  // finds the code statically and decodes it before the first frame
+  void discover_code() {
+    if (decode_cache_size() == 0) {
+      return;
+    }
+    const auto begin = std::chrono::steady_clock::now();
+    CodeWalker walker{rom_view(), ThreadPool::shared()};
+    walker.add_vector_table_entry_points();
+    walker.walk();
+    for (const auto& decoded : walker.instructions()) {
+      if (!decode_cache_.find(decoded.pc)) {
+        decode_cache_.insert(decoded.pc, decoded.instruction, decoded.next_pc);
+      }
+    }
+    code_map_ = walker.code_map();
+    const auto end = std::chrono::steady_clock::now();
+    spdlog::info("discovered {} instructions in {:.1f} ms", walker.instructions().size(),
+                 std::chrono::duration<double, std::milli>(end - begin).count());
+  }
+
+  // the cache works only if the ROM is mapped from the zero address
+  size_t decode_cache_size() const {
+    return metadata().rom_address.begin.get() == 0 ? rom_.size() : 0;
+  }
+
 private:
+  const Timing timing_;
+  const Backend backend_;
+  const bool constant_vdp_status_;
+
   // ROM content
   const std::vector<char> rom_;
+  const uint64_t rom_hash_;
+  DecodeCache decode_cache_;
+  InlineCacheTable inline_caches_;
+  // walked by the code discovery or on the first request
+  mutable std::optional<CodeMap> code_map_;
+  std::optional<IdleLoopDetector> idle_loop_detector_;
+  // the idle skips before the current frame and if the game was ever seen waiting for VBLANK
+  uint64_t frame_idle_skips_{};
+  bool waits_for_vblank_{};
+  // told about the resets, the sound devices append the writes
+  SoundLog* sound_log_{};
 
   // memory devices
   BusDevice bus_;
@@ -148,6 +643,7 @@ private:
   VdpDevice vdp_device_;
   PsgDevice psg_device_;
   M68kRamDevice m68k_ram_device_;
+  LoopAccelerator loop_accelerator_;
 
   // registers
   m68k::Registers registers_;
@@ -155,16 +651,76 @@ private:
   // interrupt handler
   InterruptHandler interrupt_handler_;
 
+  // counters
+  Executor::Statistics statistics_{};
+  uint16_t line_{kVisibleLines};
+
+  // the state after the construction for `reset`
+  Executor::Snapshot power_on_{};
+
+  // native basic blocks, may be empty
+  RecompiledCode recompiled_code_;
+
   // utils
   StateDump state_dump_;
 };
 
-Executor::Executor(std::string_view rom_path) : impl_{std::make_unique<Impl>(rom_path)} {}
+template<typename Policy>
+class Executor::TieredImpl final : public Executor::Impl {
+public:
+  TieredImpl(std::string_view rom_path, Timing timing, Backend backend)
+      : Impl{rom_path, timing, backend, /*constant_vdp_status=*/!Policy::kTrackBeam} {}
+
+  [[nodiscard]] std::expected<Executor::Result, Error> execute_instructions(uint64_t count) override {
+    for (uint64_t executed = 1;; ++executed) {
+      auto result = run_instruction<Policy>();
+      if (!result.has_value()) [[unlikely]] {
+        count_fault();
+        return result;
+      }
+      if (*result == Executor::Result::VblankInterrupt || executed >= count) {
+        return result;
+      }
+    }
+  }
+
+  uint64_t instructions_before_interrupt() const override {
+    return count_instructions_before_interrupt<Policy>();
+  }
+};
+
+Executor::Executor(std::string_view rom_path, Timing timing, Backend backend, Accuracy accuracy) {
+  const auto make_impl = [&]<typename AccuracyPolicy>() -> std::unique_ptr<Impl> {
+    switch (backend) {
+    case Backend::Reference:
+      return std::make_unique<TieredImpl<BackendPolicy<AccuracyPolicy, Backend::Reference>>>(rom_path, timing,
+                                                                                             backend);
+    case Backend::Fast:
+      return std::make_unique<TieredImpl<BackendPolicy<AccuracyPolicy, Backend::Fast>>>(rom_path, timing, backend);
+    }
+  };
+  switch (accuracy) {
+  case Accuracy::Fast:
+    impl_ = make_impl.template operator()<FastPolicy>();
+    break;
+  case Accuracy::Accurate:
+    impl_ = make_impl.template operator()<AccuratePolicy>();
+    break;
+  }
+}
 
 Executor::~Executor() = default;
 
 [[nodiscard]] std::expected<Executor::Result, Error> Executor::execute_current_instruction() {
-  return impl_->execute_single_instruction();
+  return impl_->execute_instructions(1);
+}
+
+[[nodiscard]] std::expected<Executor::Result, Error> Executor::execute_until_vblank() {
+  return impl_->execute_instructions(std::numeric_limits<uint64_t>::max());
+}
+
+bool Executor::load_recompiled_code(std::string_view path) {
+  return impl_->load_recompiled_code(path);
 }
 
 void Executor::set_game_speed(double game_speed) {
@@ -176,7 +732,47 @@ void Executor::reset_interrupt_time() {
 }
 
 Executor::InstructionInfo Executor::current_instruction_info() {
-  return impl_->current_instruction_info();
+  return impl_->instruction_info(impl_->registers().pc);
+}
+
+Executor::InstructionInfo Executor::instruction_info(AddressType pc) {
+  return impl_->instruction_info(pc);
+}
+
+void Executor::set_write_log(std::vector<BusDevice::Write>* write_log) {
+  impl_->set_write_log(write_log);
+}
+
+void Executor::set_sound_log(SoundLog* sound_log) {
+  impl_->set_sound_log(sound_log);
+}
+
+void Executor::set_idle_loop_skipping(bool enabled) {
+  impl_->set_idle_loop_skipping(enabled);
+}
+
+uint64_t Executor::instructions_before_interrupt() const {
+  return impl_->instructions_before_interrupt();
+}
+
+void Executor::advance(const m68k::Registers& registers, uint64_t instructions) {
+  impl_->advance(registers, instructions);
+}
+
+void Executor::save(Snapshot& snapshot) const {
+  impl_->save(snapshot);
+}
+
+void Executor::reset() {
+  impl_->reset();
+}
+
+void Executor::reset_to(const Snapshot& snapshot) {
+  impl_->reset_to(snapshot);
+}
+
+uint16_t Executor::beam_line() const {
+  return impl_->beam_line();
 }
 
 ControllerDevice& Executor::controller_device() {
@@ -199,6 +795,14 @@ const m68k::Registers& Executor::registers() const {
   return impl_->registers();
 }
 
+const CodeMap& Executor::code_map() const {
+  return impl_->code_map();
+}
+
+const Executor::Statistics& Executor::statistics() const {
+  return impl_->statistics();
+}
+
 void Executor::save_dump_to_file(std::string_view path) const {
   return impl_->save_dump_to_file(path);
 }
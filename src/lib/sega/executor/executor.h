@@ -1,14 +1,28 @@
 #pragma once
 #include "lib/common/error/error.h"
 #include "lib/common/memory/types.h"
+#include "lib/m68k/instruction/fusion.h"
 #include "lib/m68k/registers/registers.h"
+#include "lib/sega/executor/accuracy.h"
+#include "lib/sega/executor/backend.h"
+#include "lib/sega/executor/interrupt_handler.h"
+#include "lib/sega/executor/timing.h"
+#include "lib/sega/memory/bus_device.h"
 #include "lib/sega/memory/controller_device.h"
+#include "lib/sega/memory/sound_log.h"
 #include "lib/sega/memory/vdp_device.h"
+#include "lib/sega/memory/ym2612_device.h"
+#include "lib/sega/memory/z80_device.h"
+#include "lib/sega/recompiler/code_map.h"
 #include "lib/sega/rom_loader/rom_loader.h"
+#include "magic_enum/magic_enum.hpp"
+#include <array>
+#include <cstdint>
 #include <expected>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace sega {
 
@@ -25,26 +39,101 @@ public:
     std::string description;
   };
 
+  struct Statistics {
+    uint64_t instructions;
+    // the emulated time, the only field restored by a reset; the other counters never go back
+    uint64_t cycles;
+    // the cycles moved back by the resets, so `cycles + rewound_cycles` are the cycles emulated since the construction
+    uint64_t rewound_cycles;
+    uint64_t frames;
+    // instructions that returned an error
+    uint64_t faults;
+    // iterations of idle loops skipped until the next interrupt, counted in `instructions` and `cycles` too
+    uint64_t idle_skips;
+    uint64_t idle_cycles;
+    // frames the game didn't finish before VBLANK: it didn't reach its VBLANK wait if it's seen waiting in an idle
+    // loop, otherwise it didn't read the controller
+    uint64_t lag_frames;
+    // second instructions of fused pairs by the fusion kind, counted in `instructions` too
+    std::array<uint64_t, magic_enum::enum_count<m68k::Fusion>()> fused;
+  };
+
+  // the machine state, the buffers are reused when a snapshot is saved into again
+  struct Snapshot {
+    m68k::Registers registers;
+    std::vector<Byte> m68k_ram;
+    Z80RamDevice::State z80_ram;
+    Z80ControllerDevice::State z80_controller;
+    ControllerDevice::State controller;
+    VdpDevice::State vdp;
+    Ym2612Device::State ym2612;
+    InterruptHandler::State interrupt_handler;
+    // the emulated time is a part of the state, the frames start at the same cycles
+    uint64_t cycles;
+    uint16_t line;
+    uint64_t frame_idle_skips;
+    bool waits_for_vblank;
+  };
+
 public:
-  Executor(std::string_view rom_path);
+  Executor(std::string_view rom_path, Timing timing = Timing::RealTime, Backend backend = Backend::Fast,
+           Accuracy accuracy = Accuracy::Fast);
   ~Executor();
   [[nodiscard]] std::expected<Result, Error> execute_current_instruction();
+  // runs instructions until VBLANK or an error in one call into the run loop
+  [[nodiscard]] std::expected<Result, Error> execute_until_vblank();
+
+  // loads a plugin made by `sega_recompile`, the interpreter is used for the code outside of its blocks,
+  // for the blocks with fused pairs or idle loops and for the blocks that would run past the next interrupt check
+  bool load_recompiled_code(std::string_view path);
 
   void set_game_speed(double game_speed);
   void reset_interrupt_time();
   InstructionInfo current_instruction_info();
+  InstructionInfo instruction_info(AddressType pc);
+
+  // all bus writes are appended to the log until it's reset to nullptr
+  void set_write_log(std::vector<BusDevice::Write>* write_log);
+
+  // the sound chip writes are appended to the log with the emulated time until it's reset to nullptr
+  void set_sound_log(SoundLog* sound_log);
+
+  // enabled by default, works only in the emulated timing with the fast backend
+  void set_idle_loop_skipping(bool enabled);
+
+  // how many instructions may run before an interrupt can fire, as counted by the fast tier in the emulated timing,
+  // zero in other modes or if an interrupt is due now
+  uint64_t instructions_before_interrupt() const;
+  // takes the registers after `instructions` register-only instructions executed outside of the executor,
+  // e.g. by `m68k::execute_on_lanes`, they mustn't be more than `instructions_before_interrupt()`
+  void advance(const m68k::Registers& registers, uint64_t instructions);
+
+  // saves the machine state, the ROM and the caches made from it are kept by the executor
+  void save(Snapshot& snapshot) const;
+  // restores the power-on state or a saved one in place, reusing every buffer; the snapshot must be saved before
+  void reset();
+  void reset_to(const Snapshot& snapshot);
+
+  // the line of the beam by the emulated time, a frame starts with VBLANK on line `kVisibleLines`,
+  // meaningful only in the emulated timing
+  uint16_t beam_line() const;
 
   ControllerDevice& controller_device();
   const VdpDevice& vdp_device() const;
   const VectorTable& vector_table() const;
   const Metadata& metadata() const;
   const m68k::Registers& registers() const;
+  const CodeMap& code_map() const;
+  const Statistics& statistics() const;
 
   void save_dump_to_file(std::string_view path) const;
   void apply_dump_from_file(std::string_view path);
 
 private:
   class Impl;
+  template<typename Policy>
+  class TieredImpl;
+
   std::unique_ptr<Impl> impl_;
 };
 
@@ -0,0 +1,195 @@
+#include "idle_loop_detector.h"
+#include "lib/common/memory/device.h"
+#include "lib/common/memory/types.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/registers/registers.h"
+#include "lib/m68k/target/target.h"
+#include "lib/sega/executor/decode_cache.h"
+#include "lib/sega/memory/m68k_ram_device.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+namespace sega {
+
+namespace {
+
+// the VDP status register, both ports
+constexpr AddressType kVdpStatusBegin = 0xC00004;
+constexpr AddressType kVdpStatusEnd = 0xC00007;
+
+// the bus ignores the upper byte of the address
+constexpr AddressType kAddressMask = 0xFFFFFF;
+
+// reads don't modify registers, the address depends only on address registers
+bool is_plain_read(const m68k::Target& target) {
+  using enum m68k::Target::Kind;
+  switch (target.kind()) {
+  case DataRegisterKind:
+  case AddressRegisterKind:
+  case AddressKind:
+  case AddressDisplacementKind:
+  case ProgramCounterDisplacementKind:
+  case AbsoluteShortKind:
+  case AbsoluteLongKind:
+  case ImmediateKind:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool reads_memory(const m68k::Target& target) {
+  using enum m68k::Target::Kind;
+  return target.kind() != DataRegisterKind && target.kind() != AddressRegisterKind;
+}
+
+// all branches have the displacement relative to the address after the opcode word
+AddressType branch_target(AddressType pc, const m68k::Instruction& instruction) {
+  const auto data = instruction.data();
+  if (instruction.size() == m68k::Instruction::ByteSize) {
+    return pc + 2 + static_cast<SignedByte>(data);
+  }
+  return pc + 2 + static_cast<SignedWord>(data);
+}
+
+} // namespace
+
+IdleLoopDetector::IdleLoopDetector(const DecodeCache& decode_cache, size_t rom_size, bool constant_vdp_status)
+    : decode_cache_{decode_cache}, rom_size_{rom_size}, constant_vdp_status_{constant_vdp_status} {}
+
+void IdleLoopDetector::forget_iteration() {
+  branch_pc_ = {};
+  registers_ = {};
+  state_ = {};
+}
+
+std::optional<IdleLoopDetector::Skip> IdleLoopDetector::on_backward_branch(AddressType branch_pc,
+                                                                          const m68k::Registers& registers,
+                                                                          State state, uint64_t event_cycles) {
+  const auto begin = registers.pc;
+  if (branch_pc - begin > kMaxLoopBytes) {
+    return std::nullopt;
+  }
+
+  // compare with the previous iteration and remember this one
+  const bool same_iteration = branch_pc == branch_pc_ && state.bus_writes == state_.bus_writes &&
+                              std::memcmp(&registers, &registers_, sizeof(registers)) == 0;
+  const auto prev_state = state_;
+  branch_pc_ = branch_pc;
+  registers_ = registers;
+  state_ = state;
+  if (!same_iteration || state.cycles <= prev_state.cycles) {
+    return std::nullopt;
+  }
+
+  auto [it, inserted] = idle_loops_.try_emplace(branch_pc);
+  if (inserted) {
+    it->second = is_idle_loop(begin, branch_pc);
+  }
+  if (!it->second || !reads_constant_memory(begin, branch_pc, registers)) {
+    return std::nullopt;
+  }
+
+  // iterations that end before the next interrupt check
+  const auto iteration_cycles = state.cycles - prev_state.cycles;
+  const auto iterations = event_cycles > state.cycles ? (event_cycles - state.cycles) / iteration_cycles : 0;
+  if (iterations == 0) {
+    return std::nullopt;
+  }
+  const Skip skip{.cycles = iterations * iteration_cycles,
+                  .instructions = iterations * (state.instructions - prev_state.instructions)};
+  state_.cycles += skip.cycles;
+  state_.instructions += skip.instructions;
+  return skip;
+}
+
+bool IdleLoopDetector::is_idle_loop(AddressType begin, AddressType end) const {
+  using enum m68k::Instruction::Kind;
+  for (auto pc = begin; pc <= end;) {
+    const auto* entry = decode_cache_.find(pc);
+    if (!entry) {
+      return false;
+    }
+    const auto inst = entry->expand(pc);
+
+    switch (inst.kind()) {
+    case NopKind:
+      break;
+    case BccKind:
+      // inner branches stay in the loop, otherwise an iteration can run unchecked code
+      if (const auto target = branch_target(pc, inst); pc != end && (target < begin || target > end)) {
+        return false;
+      }
+      break;
+    case TstKind:
+      if (!is_plain_read(inst.src())) {
+        return false;
+      }
+      break;
+    case BtstKind:
+    case CmpKind:
+    case CmpaKind:
+    case CmpiKind:
+      if (!is_plain_read(inst.src()) || !is_plain_read(inst.dst())) {
+        return false;
+      }
+      break;
+    case AndKind:
+    case AndiKind:
+    case OrKind:
+    case OriKind:
+    case MoveKind:
+    case MoveqKind:
+      // address registers stay the same, so do the addresses of the reads
+      if ((inst.has_src() && !is_plain_read(inst.src())) || inst.dst().kind() != m68k::Target::DataRegisterKind) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+    }
+
+    pc += entry->length();
+    if (pc > end && pc - entry->length() != end) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IdleLoopDetector::reads_constant_memory(AddressType begin, AddressType end,
+                                             const m68k::Registers& registers) const {
+  auto context_registers = registers;
+  // the addresses don't depend on memory
+  DummyDevice device;
+  for (auto pc = begin; pc <= end;) {
+    const auto* entry = decode_cache_.find(pc);
+    const auto inst = entry->expand(pc);
+    pc += entry->length();
+
+    // PC-relative addresses are in the ROM
+    context_registers.pc = pc;
+    for (const auto* target : {&inst.src(), &inst.dst()}) {
+      if (!reads_memory(*target) || target->kind() == m68k::Target::ProgramCounterDisplacementKind ||
+          target->kind() == m68k::Target::ImmediateKind) {
+        continue;
+      }
+      const auto addr = target->effective_address({.registers = context_registers, .device = device});
+      if (!is_constant_address(addr & kAddressMask)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool IdleLoopDetector::is_constant_address(AddressType addr) const {
+  if (addr < rom_size_ || (addr >= M68kRamDevice::kBegin && addr <= M68kRamDevice::kEnd)) {
+    return true;
+  }
+  return constant_vdp_status_ && addr >= kVdpStatusBegin && addr <= kVdpStatusEnd;
+}
+
+} // namespace sega
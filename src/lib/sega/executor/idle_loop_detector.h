@@ -0,0 +1,66 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include "lib/m68k/registers/registers.h"
+#include "lib/sega/executor/decode_cache.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+namespace sega {
+
+// finds short loops that wait for an interrupt, e.g. polling a flag in RAM or the VDP status;
+// if an iteration of such loop doesn't write memory and ends with the same registers as it started,
+// the next iterations are the same until an interrupt, so they can be skipped
+class IdleLoopDetector {
+public:
+  // the executor state when a backward branch is taken
+  struct State {
+    uint64_t cycles;
+    uint64_t instructions;
+    // changed by any bus write, including the interrupt stack frames
+    uint64_t bus_writes;
+  };
+
+  // the time the executor would spend in the skipped iterations
+  struct Skip {
+    uint64_t cycles;
+    uint64_t instructions;
+  };
+
+public:
+  // `constant_vdp_status` is false if the status depends on the beam position
+  IdleLoopDetector(const DecodeCache& decode_cache, size_t rom_size, bool constant_vdp_status);
+
+  // called after a backward branch at `branch_pc` is taken, `event_cycles` is the time of the next interrupt check
+  std::optional<Skip> on_backward_branch(AddressType branch_pc, const m68k::Registers& registers, State state,
+                                         uint64_t event_cycles);
+
+  // forgets the previous iteration, the executor state may be restored to any time
+  void forget_iteration();
+
+private:
+  // only the instructions that read memory, write data registers and branch inside of the loop
+  bool is_idle_loop(AddressType begin, AddressType end) const;
+  // the memory reads don't depend on time, `registers` are the same during the iteration
+  bool reads_constant_memory(AddressType begin, AddressType end, const m68k::Registers& registers) const;
+  bool is_constant_address(AddressType addr) const;
+
+private:
+  // longer loops likely do some work
+  static constexpr AddressType kMaxLoopBytes = 32;
+
+  const DecodeCache& decode_cache_;
+  const size_t rom_size_;
+  const bool constant_vdp_status_;
+
+  // the result of `is_idle_loop` for every seen branch
+  std::unordered_map<AddressType, bool> idle_loops_;
+
+  // the previous taken backward branch
+  AddressType branch_pc_{};
+  m68k::Registers registers_{};
+  State state_{};
+};
+
+} // namespace sega
@@ -0,0 +1,41 @@
+#include "inline_cache_table.h"
+#include "lib/common/memory/types.h"
+#include "lib/sega/memory/bus_device.h"
+#include <cstddef>
+
+namespace sega {
+
+namespace {
+
+// the instructions missed by the code discovery, e.g. reached by `JMP (An)`
+constexpr size_t kExtraCaches = 4096;
+
+} // namespace
+
+InlineCacheTable::InlineCacheTable(size_t rom_size) : slot_count_{rom_size / 2} {}
+
+void InlineCacheTable::reserve(size_t count) {
+  if (slot_count_ == 0) {
+    return;
+  }
+  index_.resize(slot_count_);
+  caches_.reserve(count + kExtraCaches);
+}
+
+BusDevice::InlineCache* InlineCacheTable::find_or_insert(AddressType pc) {
+  const size_t slot = pc >> 1;
+  if ((pc & 1) || slot >= index_.size()) {
+    return nullptr;
+  }
+  if (!index_[slot]) {
+    // growing would reallocate during the frames
+    if (caches_.size() == caches_.capacity()) {
+      return nullptr;
+    }
+    caches_.push_back({});
+    index_[slot] = caches_.size();
+  }
+  return &caches_[index_[slot] - 1];
+}
+
+} // namespace sega
@@ -0,0 +1,29 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include "lib/sega/memory/bus_device.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sega {
+
+// inline caches of the bus devices for ROM instructions, one per instruction address;
+// a cache is taken from the storage reserved before the first frame on the first execution, the storage never grows
+class InlineCacheTable {
+public:
+  InlineCacheTable(size_t rom_size);
+
+  // allocates the index and the caches of `count` instructions with some room for the code found at run time
+  void reserve(size_t count);
+
+  // returns nullptr for addresses outside of the ROM or if the storage is full, the instruction isn't cached then
+  BusDevice::InlineCache* find_or_insert(AddressType pc);
+
+private:
+  const size_t slot_count_;
+  // index values are a cache position plus one, zero means no cache
+  std::vector<uint32_t> index_;
+  std::vector<BusDevice::InlineCache> caches_;
+};
+
+} // namespace sega
@@ -3,10 +3,12 @@
 #include "lib/common/memory/device.h"
 #include "lib/common/memory/types.h"
 #include "lib/m68k/registers/registers.h"
+#include "lib/sega/executor/timing.h"
 #include "lib/sega/memory/vdp_device.h"
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <optional>
 #include <spdlog/spdlog.h>
 
@@ -23,11 +25,21 @@ constexpr auto NTSC_WAIT_TIME = 1s / 60.0; // 60 frames per second
 
 } // namespace
 
-InterruptHandler::InterruptHandler(AddressType vblank_pc, m68k::Registers& registers, Device& bus_device,
-                                   const VdpDevice& vdp_device)
-    : vblank_pc_{vblank_pc}, registers_{registers}, bus_device_{bus_device}, vdp_device_{vdp_device} {}
+InterruptHandler::InterruptHandler(Timing timing, AddressType vblank_pc, AddressType hblank_pc,
+                                   m68k::Registers& registers, Device& bus_device, const VdpDevice& vdp_device)
+    : timing_{timing}, vblank_pc_{vblank_pc}, hblank_pc_{hblank_pc}, registers_{registers}, bus_device_{bus_device},
+      vdp_device_{vdp_device} {}
+
+std::expected<bool, Error> InterruptHandler::check(uint64_t cycles) {
+  switch (timing_) {
+  case Timing::RealTime:
+    return check_real_time();
+  case Timing::Emulated:
+    return check_emulated(cycles);
+  }
+}
 
-std::expected<bool, Error> InterruptHandler::check() {
+std::expected<bool, Error> InterruptHandler::check_real_time() {
   // check only VBLANK now
   if (!vdp_device_.vblank_interrupt_enabled()) {
     return false;
@@ -39,7 +51,7 @@ std::expected<bool, Error> InterruptHandler::check() {
   const auto now = std::chrono::steady_clock::now();
   if ((now - prev_fire_) >= NTSC_WAIT_TIME / game_speed_) {
     prev_fire_ = now;
-    if (auto err = call_vblank()) {
+    if (auto err = call_interrupt(VBLANK_INTERRUPT_LEVEL, vblank_pc_)) {
       return std::unexpected(*err);
     }
     return true;
@@ -48,6 +60,55 @@ std::expected<bool, Error> InterruptHandler::check() {
   return false;
 }
 
+std::expected<bool, Error> InterruptHandler::check_emulated(uint64_t cycles) {
+  // the frame ends regardless of whether the game wants the interrupt
+  bool new_frame = false;
+  if (cycles >= next_frame_cycles_) {
+    next_frame_cycles_ += kCyclesPerFrame;
+    vblank_pending_ = vdp_device_.vblank_interrupt_enabled();
+    new_frame = true;
+  }
+
+  // a masked interrupt stays pending until the game lowers the mask
+  if (vblank_pending_ && registers_.sr.interrupt_mask < VBLANK_INTERRUPT_LEVEL) {
+    vblank_pending_ = false;
+    if (auto err = call_interrupt(VBLANK_INTERRUPT_LEVEL, vblank_pc_)) {
+      return std::unexpected(*err);
+    }
+  }
+
+  return new_frame;
+}
+
+bool InterruptHandler::due(uint64_t cycles) const {
+  if (timing_ == Timing::RealTime) {
+    return false;
+  }
+  return cycles >= next_frame_cycles_ ||
+         (vblank_pending_ && registers_.sr.interrupt_mask < VBLANK_INTERRUPT_LEVEL) ||
+         (hblank_pending_ && registers_.sr.interrupt_mask < HBLANK_INTERRUPT_LEVEL);
+}
+
+uint64_t InterruptHandler::next_frame_cycles() const {
+  return timing_ == Timing::Emulated ? next_frame_cycles_ : std::numeric_limits<uint64_t>::max();
+}
+
+std::optional<Error> InterruptHandler::check_line(uint16_t line) {
+  // the counter is reloaded on every line outside of the active display
+  if (line >= kVisibleLines) {
+    hblank_counter_ = vdp_device_.hblank_interrupt_rate();
+  } else if (--hblank_counter_ < 0) {
+    hblank_counter_ = vdp_device_.hblank_interrupt_rate();
+    hblank_pending_ = vdp_device_.hblank_interrupt_enabled();
+  }
+
+  if (hblank_pending_ && registers_.sr.interrupt_mask < HBLANK_INTERRUPT_LEVEL) {
+    hblank_pending_ = false;
+    return call_interrupt(HBLANK_INTERRUPT_LEVEL, hblank_pc_);
+  }
+  return std::nullopt;
+}
+
 void InterruptHandler::set_game_speed(double game_speed) {
   game_speed_ = game_speed;
 }
@@ -56,7 +117,24 @@ void InterruptHandler::reset_time() {
   prev_fire_ = std::chrono::steady_clock::now();
 }
 
-std::optional<Error> InterruptHandler::call_vblank() {
+void InterruptHandler::save_state(State& state) const {
+  state = {
+      .next_frame_cycles = next_frame_cycles_,
+      .vblank_pending = vblank_pending_,
+      .hblank_counter = hblank_counter_,
+      .hblank_pending = hblank_pending_,
+  };
+}
+
+void InterruptHandler::load_state(const State& state) {
+  next_frame_cycles_ = state.next_frame_cycles;
+  vblank_pending_ = state.vblank_pending;
+  hblank_counter_ = state.hblank_counter;
+  hblank_pending_ = state.hblank_pending;
+  reset_time();
+}
+
+std::optional<Error> InterruptHandler::call_interrupt(uint8_t level, AddressType pc) {
   // push PC (4 bytes)
   auto& sp = registers_.stack_ptr();
   sp -= 4;
@@ -70,10 +148,10 @@ std::optional<Error> InterruptHandler::call_vblank() {
     return err;
   }
 
-  // make supervisor, set priority mask, jump to VBLANK
-  registers_.sr.supervisor = 1;
-  registers_.sr.interrupt_mask = VBLANK_INTERRUPT_LEVEL;
-  registers_.pc = vblank_pc_;
+  // make supervisor, set priority mask, jump to the handler
+  registers_.set_supervisor(true);
+  registers_.sr.interrupt_mask = level;
+  registers_.pc = pc;
 
   return std::nullopt;
 }
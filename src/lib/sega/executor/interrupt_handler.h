@@ -3,34 +3,70 @@
 #include "lib/common/memory/device.h"
 #include "lib/common/memory/types.h"
 #include "lib/m68k/registers/registers.h"
+#include "lib/sega/executor/timing.h"
 #include "lib/sega/memory/vdp_device.h"
 #include <chrono>
+#include <cstdint>
 #include <optional>
 
 namespace sega {
 
 class InterruptHandler {
 public:
-  InterruptHandler(AddressType vblank_pc, m68k::Registers& registers, Device& bus_device,
-                   const VdpDevice& vdp_device);
+  // the emulated time state restored in place by the executor reset
+  struct State {
+    uint64_t next_frame_cycles;
+    bool vblank_pending;
+    int hblank_counter;
+    bool hblank_pending;
+  };
 
-  // returns true if an interrupt created
-  [[nodiscard]] std::expected<bool, Error> check();
+  InterruptHandler(Timing timing, AddressType vblank_pc, AddressType hblank_pc, m68k::Registers& registers,
+                   Device& bus_device, const VdpDevice& vdp_device);
+
+  // returns true if a new frame started, `cycles` is the emulated time
+  [[nodiscard]] std::expected<bool, Error> check(uint64_t cycles);
+
+  // returns true if the next `check` may do something, the real time interrupts are never due and just come later
+  bool due(uint64_t cycles) const;
+
+  // the emulated time of the next frame, the maximum value in the real time
+  uint64_t next_frame_cycles() const;
+
+  // counts down the HBLANK interrupt rate, called on every new line if the beam is tracked
+  [[nodiscard]] std::optional<Error> check_line(uint16_t line);
 
   void set_game_speed(double game_speed);
   void reset_time();
 
+  void save_state(State& state) const;
+  void load_state(const State& state);
+
 private:
-  [[nodiscard]] std::optional<Error> call_vblank();
+  [[nodiscard]] std::expected<bool, Error> check_real_time();
+  [[nodiscard]] std::expected<bool, Error> check_emulated(uint64_t cycles);
+
+  [[nodiscard]] std::optional<Error> call_interrupt(uint8_t level, AddressType pc);
 
 private:
+  const Timing timing_;
   const AddressType vblank_pc_;
+  const AddressType hblank_pc_;
   m68k::Registers& registers_;
   Device& bus_device_;
   const VdpDevice& vdp_device_;
 
+  // real time
   double game_speed_{1.0};
   std::chrono::time_point<std::chrono::steady_clock> prev_fire_{};
+
+  // emulated time
+  uint64_t next_frame_cycles_{kCyclesPerFrame};
+  bool vblank_pending_{};
+
+  // lines
+  int hblank_counter_{};
+  bool hblank_pending_{};
 };
 
 } // namespace sega
@@ -0,0 +1,192 @@
+#include "loop_accelerator.h"
+#include "lib/common/error/error.h"
+#include "lib/common/memory/device.h"
+#include "lib/common/memory/types.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/registers/registers.h"
+#include "lib/m68k/target/target.h"
+#include "lib/sega/memory/bus_device.h"
+#include "lib/sega/memory/m68k_ram_device.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <optional>
+
+namespace sega {
+
+namespace {
+
+// the bus ignores the upper byte of the address
+constexpr AddressType kAddressMask = 0xFFFFFF;
+
+// the VDP data port, both addresses
+constexpr AddressType kVdpData1 = 0xC00000;
+constexpr AddressType kVdpData2 = 0xC00002;
+
+// the stack pointer is incremented by 2 for bytes, such loops are left to the interpreter
+bool is_plain_register(const m68k::Target& target) {
+  return target.index() != 7;
+}
+
+bool is_vdp_data_port(AddressType addr) {
+  return addr == kVdpData1 || addr == kVdpData2;
+}
+
+// the last element as a big-endian number
+Long last_element(DataView data, AddressType size) {
+  Long value = 0;
+  for (auto i = data.size() - size; i < data.size(); ++i) {
+    value = (value << 8) | data[i];
+  }
+  return value;
+}
+
+void set_move_flags(m68k::Registers& registers, Long value, AddressType size) {
+  const auto bits = size * 8;
+  const Long mask = bits == 32 ? ~Long{0} : (Long{1} << bits) - 1;
+  registers.sr.negative = (value >> (bits - 1)) & 1;
+  registers.sr.zero = (value & mask) == 0;
+  registers.sr.overflow = false;
+  registers.sr.carry = false;
+}
+
+} // namespace
+
+LoopAccelerator::LoopAccelerator(DataView rom, M68kRamDevice& ram_device, BusDevice& bus_device)
+    : rom_{rom}, ram_{ram_device.data()}, bus_device_{bus_device} {}
+
+std::expected<uint64_t, Error> LoopAccelerator::run(const m68k::Instruction& body, const m68k::Instruction& dbcc,
+                                                    AddressType exit_pc, m68k::Registers& registers,
+                                                    uint64_t max_iterations) {
+  if (dbcc.condition() != m68k::Instruction::FalseCond || dbcc.dst().kind() != m68k::Target::DataRegisterKind) {
+    return 0;
+  }
+
+  // the counter isn't -1 because the branch is taken
+  auto& counter = registers.d()[dbcc.dst().index()];
+  const uint64_t remaining = (counter & 0xFFFF) + 1;
+  const uint64_t iterations = std::min(remaining, max_iterations);
+  const AddressType size = body.size();
+  const uint64_t length = iterations * size;
+  if (iterations == 0) {
+    return 0;
+  }
+
+  const auto& dst = body.dst();
+  if (!is_plain_register(dst)) {
+    return 0;
+  }
+  const AddressType dst_addr = registers.a()[dst.index()] & kAddressMask;
+  const bool dst_is_port = dst.kind() == m68k::Target::AddressKind;
+  if (dst_is_port && !is_vdp_data_port(dst_addr)) {
+    return 0;
+  }
+  if (size > 1 && (dst_addr & 1)) {
+    return 0;
+  }
+
+  // the value of the last element sets the flags
+  Long last_value = 0;
+
+  if (body.kind() == m68k::Instruction::MoveKind && body.src().kind() == m68k::Target::AddressIncrementKind) {
+    // copy loop
+    const auto& src = body.src();
+    const AddressType src_addr = registers.a()[src.index()] & kAddressMask;
+    if (!is_plain_register(src) || src.index() == dst.index() || (size > 1 && (src_addr & 1))) {
+      return 0;
+    }
+    const auto source = readable(src_addr, length);
+    if (!source) {
+      return 0;
+    }
+    if (dst_is_port) {
+      if (auto err = stream(dst_addr, *source, iterations, size, size)) {
+        return std::unexpected{std::move(*err)};
+      }
+    } else {
+      // overlapping ranges are copied element by element by the game, it's left to the interpreter
+      const auto destination = writable(dst_addr, length);
+      if (!destination || (src_addr < dst_addr + length && dst_addr < src_addr + length)) {
+        return 0;
+      }
+      std::memcpy(destination->data(), source->data(), length);
+      bus_device_.add_direct_writes(dst_addr, *source, size);
+    }
+    registers.a()[src.index()] += length;
+    last_value = last_element(*source, size);
+  } else if (body.kind() == m68k::Instruction::MoveKind) {
+    // fill loop with a register value
+    const Long value = registers.d()[body.src().index()];
+    std::array<Byte, 4> element;
+    for (AddressType i = 0; i < size; ++i) {
+      element[i] = value >> (8 * (size - 1 - i));
+    }
+    if (dst_is_port) {
+      if (auto err = stream(dst_addr, DataView{element.data(), size}, iterations, size, 0)) {
+        return std::unexpected{std::move(*err)};
+      }
+    } else {
+      const auto destination = writable(dst_addr, length);
+      if (!destination) {
+        return 0;
+      }
+      for (uint64_t offset = 0; offset < length; offset += size) {
+        std::memcpy(destination->data() + offset, element.data(), size);
+      }
+      bus_device_.add_direct_writes(dst_addr, DataView{*destination}, size);
+    }
+    last_value = value;
+  } else {
+    // CLR reads the destination before writing, so only RAM is cleared
+    const auto destination = writable(dst_addr, length);
+    if (dst_is_port || !destination) {
+      return 0;
+    }
+    std::memset(destination->data(), 0, length);
+    bus_device_.add_direct_writes(dst_addr, DataView{*destination}, size);
+  }
+
+  if (!dst_is_port) {
+    registers.a()[dst.index()] += length;
+  }
+  set_move_flags(registers, last_value, size);
+
+  // DBF decrements the low word only
+  counter = (counter & 0xFFFF0000) | ((remaining - 1 - iterations) & 0xFFFF);
+  if (iterations == remaining) {
+    registers.pc = exit_pc;
+  }
+  return iterations;
+}
+
+std::optional<DataView> LoopAccelerator::readable(AddressType addr, uint64_t size) const {
+  if (addr + size <= rom_.size()) {
+    return DataView{rom_.data() + addr, size};
+  }
+  if (addr >= M68kRamDevice::kBegin && addr + size <= M68kRamDevice::kEnd + 1) {
+    return DataView{ram_.subspan(addr - M68kRamDevice::kBegin, size)};
+  }
+  return std::nullopt;
+}
+
+std::optional<MutableDataView> LoopAccelerator::writable(AddressType addr, uint64_t size) const {
+  if (addr >= M68kRamDevice::kBegin && addr + size <= M68kRamDevice::kEnd + 1) {
+    return ram_.subspan(addr - M68kRamDevice::kBegin, size);
+  }
+  return std::nullopt;
+}
+
+std::optional<Error> LoopAccelerator::stream(AddressType port, DataView data, uint64_t count, AddressType size,
+                                             AddressType step) {
+  Device& device = bus_device_;
+  for (uint64_t i = 0; i < count; ++i) {
+    if (auto err = device.write(port, DataView{data.data() + i * step, size})) {
+      return err;
+    }
+  }
+  return std::nullopt;
+}
+
+} // namespace sega
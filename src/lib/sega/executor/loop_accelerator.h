@@ -0,0 +1,40 @@
+#pragma once
+#include "lib/common/error/error.h"
+#include "lib/common/memory/types.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/registers/registers.h"
+#include "lib/sega/memory/bus_device.h"
+#include "lib/sega/memory/m68k_ram_device.h"
+#include <cstdint>
+#include <expected>
+#include <optional>
+
+namespace sega {
+
+// runs copy and fill loops of one instruction and DBF at once, e.g. `MOVE.L (A0)+,(A1)+` / `DBF D0`;
+// the memory is copied directly if it's in RAM or ROM, or streamed into the VDP data port
+class LoopAccelerator {
+public:
+  LoopAccelerator(DataView rom, M68kRamDevice& ram_device, BusDevice& bus_device);
+
+  // the loop has just branched back to `body`, `exit_pc` is the address after `dbcc`;
+  // runs up to `max_iterations` iterations, returns their number or zero if the loop can't be accelerated
+  std::expected<uint64_t, Error> run(const m68k::Instruction& body, const m68k::Instruction& dbcc,
+                                     AddressType exit_pc, m68k::Registers& registers, uint64_t max_iterations);
+
+private:
+  // `size` bytes from the address in RAM or ROM, for reading
+  std::optional<DataView> readable(AddressType addr, uint64_t size) const;
+  // `size` bytes from the address in RAM, for writing
+  std::optional<MutableDataView> writable(AddressType addr, uint64_t size) const;
+
+  // writes `count` elements of `size` bytes, the element `i` starts at `data[i * step]`
+  std::optional<Error> stream(AddressType port, DataView data, uint64_t count, AddressType size, AddressType step);
+
+private:
+  const DataView rom_;
+  const MutableDataView ram_;
+  BusDevice& bus_device_;
+};
+
+} // namespace sega
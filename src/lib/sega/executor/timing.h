@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+
+namespace sega {
+
+// NTSC timings: the 68000 runs at ~7.67 MHz, there are 262 lines per frame and 60 frames per second
+constexpr uint64_t kCyclesPerLine = 488;
+constexpr uint64_t kLinesPerFrame = 262;
+constexpr uint64_t kCyclesPerFrame = kCyclesPerLine * kLinesPerFrame;
+
+// the active display is 224 lines, VBLANK starts right after it
+constexpr uint16_t kVisibleLines = 224;
+
+// there is no cycle-exact timing, every instruction is assumed to take the same time
+constexpr uint64_t kApproximateInstructionCycles = 10;
+
+enum class Timing {
+  // VBLANK is fired every 1/60 of a real second (scaled by the game speed), used for interactive play
+  RealTime,
+
+  // VBLANK is fired every `kCyclesPerFrame` emulated cycles, the run is fully deterministic
+  Emulated,
+};
+
+} // namespace sega
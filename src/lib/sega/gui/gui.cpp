@@ -9,7 +9,11 @@
 #include "imgui_impl_opengl3.h"
 #include "lib/common/memory/types.h"
 #include "lib/sega/executor/executor.h"
+#include "lib/sega/executor/timing.h"
 #include "lib/sega/memory/controller_device.h"
+#include "lib/sega/metrics/metrics.h"
+#include "lib/sega/perf/perf_counters.h"
+#include "lib/sega/recompiler/code_map.h"
 #include "lib/sega/rom_loader/rom_loader.h"
 #include "lib/sega/shader/shader.h"
 #include "lib/sega/video/colors.h"
@@ -17,8 +21,10 @@
 #include "lib/sega/video/plane.h"
 #include "magic_enum/magic_enum.hpp"
 #include <GL/gl.h>
+#include <algorithm>
 #include <array>
 #include <bit>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -29,6 +35,7 @@
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 
 // reference: https://github.com/ocornut/imgui/blob/master/examples/example_sdl2_opengl3/main.cpp
@@ -43,6 +50,9 @@ constexpr auto kRegisterColor = ImVec4{1, 0, 0, 1};    // red
 constexpr auto kBytesColor = ImVec4{1, 1, 0, 1};       // yellow
 constexpr auto kSizeColor = ImVec4{1, 1, 0, 1};        // yellow
 constexpr auto kDescriptionColor = ImVec4{1, 0, 1, 1}; // pink
+constexpr auto kCodeColor = ImVec4{0, 1, 0, 1};        // green
+constexpr auto kJumpTableColor = ImVec4{0, 1, 1, 1};   // cyan
+constexpr auto kDataColor = ImVec4{0.5, 0.5, 0.5, 1};  // gray
 
 void glfw_error_callback(int error, const char* description) {
   spdlog::error("GLFW error code: {} description: {}", error, description);
@@ -125,14 +135,46 @@ bool Gui::setup() {
 
 void Gui::loop() {
   while (poll_events()) {
+    const auto begin = std::chrono::steady_clock::now();
+    pacing_time_ = {};
     update_controller();
+    enter_perf_phase(PerfPhase::Cpu);
     execute();
-    video_.update();
+    if (!beam_racing_) {
+      enter_perf_phase(PerfPhase::Vdp);
+      video_.update();
+    }
+    enter_perf_phase(PerfPhase::Present);
     render();
+    if (perf_counters_) {
+      perf_counters_->leave();
+    }
+    if (metrics_recorder_) {
+      metrics_recorder_->on_frame(std::chrono::steady_clock::now() - begin - pacing_time_);
+    }
+  }
+}
+
+void Gui::set_metrics(Metrics& metrics) {
+  metrics_recorder_.emplace(metrics, executor_);
+}
+
+void Gui::set_beam_racing(bool enabled) {
+  beam_racing_ = enabled;
+}
+
+void Gui::enable_perf_counters() {
+  perf_counters_.emplace();
+}
+
+void Gui::enter_perf_phase(PerfPhase phase) {
+  if (perf_counters_) {
+    perf_counters_->enter(phase);
   }
 }
 
 void Gui::execute() {
+  const auto begin = std::chrono::steady_clock::now();
   while (condition_ && !condition_()) {
     const auto result = executor_.execute_current_instruction();
     ++executed_count_;
@@ -140,13 +182,54 @@ void Gui::execute() {
       spdlog::error("current instruction error kind: {} what: {}", magic_enum::enum_name(result.error().kind()),
                     result.error().what());
     }
-    if (result.value() == Executor::Result::VblankInterrupt) {
+    const bool vblank = result.value() == Executor::Result::VblankInterrupt;
+    if (beam_racing_) {
+      race_beam(vblank);
+    }
+    if (vblank) {
       break;
     }
   }
   if (condition_ && condition_()) {
     condition_ = nullptr;
   }
+  // without the beam racing the executor runs in the real time, it executes until VBLANK is due by the host clock,
+  // so the execution lasts until the frame time whatever the work is
+  if (!beam_racing_) {
+    pacing_time_ = std::chrono::steady_clock::now() - begin;
+  }
+}
+
+void Gui::race_beam(bool vblank) {
+  if (vblank) {
+    // the rest of the lines, e.g. the bottom of a 240-line display, and the last band
+    enter_perf_phase(PerfPhase::Vdp);
+    video_.update();
+    video_.draw();
+    wait_next_frame();
+    return;
+  }
+
+  // the line under the beam is in progress, so only the lines above it are rendered when the beam moves
+  if (const auto line = executor_.beam_line(); line < kVisibleLines && line != raced_line_) {
+    raced_line_ = line;
+    enter_perf_phase(PerfPhase::Vdp);
+    video_.update_lines(line);
+    video_.upload_band();
+    enter_perf_phase(PerfPhase::Cpu);
+  }
+}
+
+void Gui::wait_next_frame() {
+  constexpr auto kFrameTime = std::chrono::duration<double>{1.0 / 60};
+  const auto now = std::chrono::steady_clock::now();
+  next_frame_time_ += std::chrono::duration_cast<std::chrono::steady_clock::duration>(kFrameTime / game_speed_value_);
+  // don't catch up after a pause
+  if (next_frame_time_ < now) {
+    next_frame_time_ = now;
+  }
+  std::this_thread::sleep_until(next_frame_time_);
+  pacing_time_ += std::chrono::steady_clock::now() - now;
 }
 
 void Gui::render() {
@@ -177,6 +260,9 @@ void Gui::render() {
   if (show_sprite_table_window_) {
     add_sprite_table_window();
   }
+  if (show_rom_window_) {
+    add_rom_window();
+  }
   if (show_demo_window_) {
     ImGui::ShowDemoWindow(&show_demo_window_);
   }
@@ -252,6 +338,7 @@ void Gui::add_main_window() {
   ImGui::Checkbox("\"Plane B\" Plane Window", &show_plane_window_[1]);
   ImGui::Checkbox("\"Window\" Plane Window", &show_plane_window_[2]);
   ImGui::Checkbox("Sprite Table Window", &show_sprite_table_window_);
+  ImGui::Checkbox("ROM Window", &show_rom_window_);
   // ImGui::Checkbox("Demo Window", &show_demo_window_);
   if (ImGui::Button("Save Dump")) {
     executor_.save_dump_to_file("dump.bin");
@@ -352,6 +439,7 @@ void Gui::add_game_window() {
   ImGui::SliderInt("Game Speed", reinterpret_cast<int*>(&game_speed_), 0, magic_enum::enum_count<GameSpeed>() - 1,
                    game_speed_str);
   executor_.set_game_speed(game_speed_value);
+  game_speed_value_ = game_speed_value;
 
   // scale selection
   ImGui::SliderInt("Scale##Game", &game_scale_, /*v_min=*/1, /*v_max=*/8);
@@ -405,12 +493,68 @@ void Gui::add_execution_window_statistics() {
   ImGui::SeparatorText("Statistics");
   ImGui::Text("Status: %s", condition_ ? "Running" : "Stopped");
   ImGui::Text("Executed Instructions: %s", fmt::format("{:L}", executed_count_).c_str());
+  // the game's own slowdowns, the idle loops are found only in the emulated timing
+  const auto& statistics = executor_.statistics();
+  ImGui::Text("Lag Frames: %s of %s", fmt::format("{:L}", statistics.lag_frames).c_str(),
+              fmt::format("{:L}", statistics.frames).c_str());
+  ImGui::Text("Idle Cycles: %.1f%%",
+              statistics.cycles > 0 ? 100.0 * statistics.idle_cycles / statistics.cycles : 0.0);
   if (condition_) {
     auto& io = ImGui::GetIO();
     ImGui::Text("Performance: %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
   } else {
     ImGui::Text("Performance: <STOPPED>");
   }
+  if (perf_counters_) {
+    add_execution_window_perf_counters();
+  }
+}
+
+void Gui::add_execution_window_perf_counters() {
+  const auto& report = perf_counters_->report();
+  if (!report.available) {
+    ImGui::Text("Hardware Counters: <UNAVAILABLE>");
+    return;
+  }
+
+  // the share of the host cycles, the instructions per cycle and the misses per 1000 instructions since the start
+  uint64_t total_cycles = 0;
+  for (const auto phase : magic_enum::enum_values<PerfPhase>()) {
+    total_cycles += report.count(phase, PerfEvent::Cycles);
+  }
+  const auto ratio = [&](PerfPhase phase, PerfEvent event, PerfEvent base, double scale) -> std::string {
+    const auto base_count = report.count(phase, base);
+    if (!report.supported[std::to_underlying(event)] || !report.supported[std::to_underlying(base)] ||
+        base_count == 0) {
+      return "n/a";
+    }
+    return fmt::format("{:.2f}", scale * report.count(phase, event) / base_count);
+  };
+
+  static constexpr ImGuiTableFlags kFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+  if (ImGui::BeginTable("perf_counters", 6, kFlags)) {
+    ImGui::TableSetupColumn("Phase");
+    ImGui::TableSetupColumn("Cycles");
+    ImGui::TableSetupColumn("IPC");
+    ImGui::TableSetupColumn("Branch MPKI");
+    ImGui::TableSetupColumn("L1D MPKI");
+    ImGui::TableSetupColumn("LLC MPKI");
+    ImGui::TableHeadersRow();
+    for (const auto phase : magic_enum::enum_values<PerfPhase>()) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%s", magic_enum::enum_name(phase).data());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f%%", total_cycles ? 100.0 * report.count(phase, PerfEvent::Cycles) / total_cycles : 0.0);
+      ImGui::TableNextColumn();
+      ImGui::Text("%s", ratio(phase, PerfEvent::Instructions, PerfEvent::Cycles, 1).c_str());
+      for (const auto event : {PerfEvent::BranchMisses, PerfEvent::L1dMisses, PerfEvent::LlcMisses}) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%s", ratio(phase, event, PerfEvent::Instructions, 1000).c_str());
+      }
+    }
+    ImGui::EndTable();
+  }
 }
 
 void Gui::add_execution_window_instruction_info() {
@@ -478,6 +622,11 @@ void Gui::add_execution_window_commands() {
     condition_ = nullptr;
   }
 
+  ImGui::Separator();
+  if (ImGui::Button("Reset")) {
+    executor_.reset();
+  }
+
   // should reset interrupt time if condition has been jus tset
   if (!has_condition && condition_) {
     executor_.reset_interrupt_time();
@@ -494,13 +643,13 @@ void Gui::add_execution_window_registers() {
   ImGui::TextColored(kRegisterColor, "%0 " size "X", value);
 #define ADD_REGISTER(value, ...) ADD_REGISTER_WITH_SIZE("8", value, __VA_ARGS__)
   for (size_t i = 0; i < 7; ++i) {
-    ADD_REGISTER(registers.d[i], "D%zu =", i)
+    ADD_REGISTER(registers.d()[i], "D%zu =", i)
     ImGui::SameLine();
-    ADD_REGISTER(registers.a[i], "A%zu =", i)
+    ADD_REGISTER(registers.a()[i], "A%zu =", i)
   }
-  ADD_REGISTER(registers.d[7], "D7 =")
-  ADD_REGISTER(registers.usp, "USP =")
-  ADD_REGISTER(registers.ssp, "SSP =")
+  ADD_REGISTER(registers.d()[7], "D7 =")
+  ADD_REGISTER(registers.usp(), "USP =")
+  ADD_REGISTER(registers.ssp(), "SSP =")
   ADD_REGISTER(registers.pc, "PC =")
 
   // show status register
@@ -651,4 +800,78 @@ void Gui::add_sprite_table_window() {
   ImGui::End();
 }
 
+void Gui::add_rom_window() {
+  ImGui::Begin("ROM", &show_rom_window_, ImGuiWindowFlags_NoNav);
+  const auto& code_map = executor_.code_map();
+
+  static constexpr std::array kKinds = {CodeMap::Kind::Code, CodeMap::Kind::JumpTable, CodeMap::Kind::Data};
+  const auto kind_color = [](CodeMap::Kind kind) {
+    switch (kind) {
+    case CodeMap::Kind::Code:
+      return kCodeColor;
+    case CodeMap::Kind::JumpTable:
+      return kJumpTableColor;
+    default:
+      return kDataColor;
+    }
+  };
+
+  // sizes of each kind
+  size_t total_words = 0;
+  for (const auto kind : kKinds) {
+    total_words += code_map.count(kind);
+  }
+  for (const auto kind : kKinds) {
+    const auto words = code_map.count(kind);
+    ImGui::Text("%s =", magic_enum::enum_name(kind).data());
+    ImGui::SameLine();
+    ImGui::TextColored(kind_color(kind), "%s bytes (%.1f%%)", fmt::format("{:L}", words * 2).c_str(),
+                       total_words ? 100.0 * words / total_words : 0.0);
+  }
+
+  // the whole ROM as a colored strip
+  const auto& regions = code_map.regions();
+  if (total_words > 0) {
+    const auto width = ImGui::GetContentRegionAvail().x;
+    constexpr float kStripHeight = 16;
+    const auto origin = ImGui::GetCursorScreenPos();
+    auto* draw_list = ImGui::GetWindowDrawList();
+    const auto scale = width / static_cast<float>(total_words * 2);
+    for (const auto& region : regions) {
+      const auto x0 = origin.x + scale * static_cast<float>(region.begin);
+      const auto x1 = std::max(origin.x + scale * static_cast<float>(region.end), x0 + 1);
+      draw_list->AddRectFilled(ImVec2(x0, origin.y), ImVec2(x1, origin.y + kStripHeight),
+                               ImGui::GetColorU32(kind_color(region.kind)));
+    }
+    ImGui::Dummy(ImVec2(width, kStripHeight));
+  }
+
+  // all regions
+  static constexpr ImGuiTableFlags kFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+  if (ImGui::BeginTable("rom_regions", 3, kFlags)) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Begin");
+    ImGui::TableSetupColumn("End");
+    ImGui::TableSetupColumn("Kind");
+    ImGui::TableHeadersRow();
+    ImGuiListClipper clipper;
+    clipper.Begin(regions.size());
+    while (clipper.Step()) {
+      for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+        const auto& region = regions[i];
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextColored(kRegisterColor, "%06X", region.begin);
+        ImGui::TableNextColumn();
+        ImGui::TextColored(kRegisterColor, "%06X", region.end);
+        ImGui::TableNextColumn();
+        ImGui::TextColored(kind_color(region.kind), "%s", magic_enum::enum_name(region.kind).data());
+      }
+    }
+    ImGui::EndTable();
+  }
+
+  ImGui::End();
+}
+
 } // namespace sega
@@ -2,6 +2,9 @@
 #include "GLFW/glfw3.h"
 #include "imgui.h"
 #include "lib/sega/executor/executor.h"
+#include "lib/sega/executor/timing.h"
+#include "lib/sega/metrics/metrics.h"
+#include "lib/sega/perf/perf_counters.h"
 #include "lib/sega/shader/shader.h"
 #include "lib/sega/video/plane.h"
 #include "lib/sega/video/sprite_table.h"
@@ -9,8 +12,10 @@
 #include "lib/sega/video/video.h"
 #include <GL/gl.h>
 #include <array>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <optional>
 #include <span>
 
 namespace sega {
@@ -23,6 +28,18 @@ public:
   bool setup();
   void loop();
 
+  // the counters are updated after every GUI frame, its time doesn't include the waits for the frame time
+  void set_metrics(Metrics& metrics);
+
+  // renders each line as soon as the emulated beam passes it and uploads it in bands, so the frame is ready
+  // right at VBLANK, the executor must run in the emulated timing and the accurate tier, otherwise HBLANK
+  // interrupts don't fire and the beam position is estimated
+  void set_beam_racing(bool enabled);
+
+  // hardware counters for the CPU emulation, the VDP rendering and the presentation in the statistics,
+  // must be called on the GUI thread
+  void enable_perf_counters();
+
 private:
   // Poll events, returns false if should stop
   bool poll_events();
@@ -33,6 +50,15 @@ private:
   // Execute instructions while conditions is met or there is a VBlank
   void execute();
 
+  // Render the lines passed by the beam, finish the frame on VBlank
+  void race_beam(bool vblank);
+
+  // Account the hardware counters to the next phase of the frame
+  void enter_perf_phase(PerfPhase phase);
+
+  // Wait for the next frame time in the emulated timing
+  void wait_next_frame();
+
   // Render whole screen
   void render();
 
@@ -45,6 +71,7 @@ private:
   // Execution window
   void add_execution_window();
   void add_execution_window_statistics();
+  void add_execution_window_perf_counters();
   void add_execution_window_instruction_info();
   void add_execution_window_commands();
   void add_execution_window_registers();
@@ -61,9 +88,14 @@ private:
   // Sprite table window
   void add_sprite_table_window();
 
+  // ROM window
+  void add_rom_window();
+
 private:
   Executor& executor_;
   GLFWwindow* window_{};
+  std::optional<Metrics::Recorder> metrics_recorder_;
+  std::optional<PerfCounters> perf_counters_;
 
   // Shader variables
   Shader shader_;
@@ -79,8 +111,15 @@ private:
     x1p50,
     x2p00,
   } game_speed_{GameSpeed::x1p00};
+  double game_speed_value_{1.0};
   int game_scale_{1};
   Video video_;
+  bool beam_racing_{false};
+  // the line passed by the beam at the last check
+  uint16_t raced_line_{kVisibleLines};
+  std::chrono::steady_clock::time_point next_frame_time_{};
+  // the time of the current GUI frame spent waiting for the frame time
+  std::chrono::steady_clock::duration pacing_time_{};
 
   // Execution window
   bool show_execution_window_{true};
@@ -109,6 +148,9 @@ private:
   std::span<const Sprite> sprites_;
   std::span<const ImTextureID> sprite_textures_;
 
+  // ROM window
+  bool show_rom_window_{false};
+
   // Demo window
   bool show_demo_window_{false};
 };
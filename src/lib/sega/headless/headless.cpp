@@ -0,0 +1,191 @@
+#include "headless.h"
+#include "lib/common/util/hash.h"
+#include "lib/sega/executor/accuracy.h"
+#include "lib/sega/executor/backend.h"
+#include "lib/sega/executor/executor.h"
+#include "lib/sega/executor/timing.h"
+#include "lib/sega/memory/controller_device.h"
+#include "magic_enum/magic_enum.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace sega {
+
+namespace {
+
+std::vector<uint8_t> load_movie(const std::filesystem::path& path) {
+  std::ifstream file{path, std::ios::binary};
+  return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+} // namespace
+
+double RunReport::fps() const {
+  return host_seconds > 0 ? frames / host_seconds : 0;
+}
+
+double RunReport::mips() const {
+  return host_seconds > 0 ? instructions / host_seconds / 1e6 : 0;
+}
+
+double RunReport::fused_percent() const {
+  // both instructions of a pair are fused
+  const auto fused_instructions = 2 * std::accumulate(fused.begin(), fused.end(), uint64_t{0});
+  return instructions > 0 ? 100.0 * fused_instructions / instructions : 0;
+}
+
+double RunReport::idle_percent() const {
+  return cycles > 0 ? 100.0 * idle_cycles / cycles : 0;
+}
+
+HeadlessRunner::HeadlessRunner(RunOptions options)
+    : options_{std::move(options)},
+      executor_{options_.rom_path.string(), Timing::Emulated, Backend::Fast, options_.accuracy},
+      video_{executor_.vdp_device()} {
+  report_.rom_name = options_.rom_path.filename().string();
+  report_.frame_hash = kFnvOffsetBasis;
+  if (options_.movie_path) {
+    movie_ = load_movie(*options_.movie_path);
+  }
+  if (options_.savestate_path) {
+    executor_.apply_dump_from_file(options_.savestate_path->string());
+  }
+  if (options_.recompiled_path) {
+    executor_.load_recompiled_code(options_.recompiled_path->string());
+  }
+  executor_.set_idle_loop_skipping(options_.skip_idle_loops);
+  if (options_.metrics) {
+    metrics_recorder_.emplace(*options_.metrics, executor_);
+  }
+  if (options_.sound) {
+    sound_log_.emplace();
+    sound_worker_.emplace(*sound_log_, [this](std::span<const int16_t> samples) {
+      sound_hash_ = fnv1a({reinterpret_cast<const uint8_t*>(samples.data()), samples.size_bytes()}, sound_hash_);
+    });
+    executor_.set_sound_log(&*sound_log_);
+  }
+  if (options_.perf) {
+    perf_counters_.emplace();
+  }
+}
+
+bool HeadlessRunner::run_frame() {
+  if (report_.aborted || report_.frames >= options_.frames) {
+    return false;
+  }
+  apply_movie_input();
+
+  const auto begin = std::chrono::steady_clock::now();
+  if (perf_counters_) {
+    perf_counters_->enter(PerfPhase::Cpu);
+  }
+  while (true) {
+    const auto result = executor_.execute_until_vblank();
+    if (!result.has_value()) {
+      if (++report_.faults >= kMaxFaults) {
+        spdlog::warn("too many faults in {}, aborting", report_.rom_name);
+        report_.aborted = true;
+        break;
+      }
+      continue;
+    }
+    if (result.value() == Executor::Result::VblankInterrupt) {
+      break;
+    }
+  }
+  if (sound_log_) {
+    // the worker synthesizes the frame while the next one is emulated
+    sound_log_->end_frame(executor_.statistics().cycles);
+  }
+  if (perf_counters_) {
+    perf_counters_->enter(PerfPhase::Vdp);
+  }
+  const auto frame = video_.update();
+  if (perf_counters_) {
+    perf_counters_->enter(PerfPhase::Present);
+  }
+  report_.frame_hash = fnv1a(frame, report_.frame_hash);
+  if (perf_counters_) {
+    perf_counters_->leave();
+    report_.perf = perf_counters_->report();
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  ++report_.frames;
+  report_.host_seconds += std::chrono::duration<double>(end - begin).count();
+  if (metrics_recorder_) {
+    metrics_recorder_->on_frame(end - begin);
+  }
+  const auto& statistics = executor_.statistics();
+  report_.instructions = statistics.instructions;
+  report_.cycles = statistics.cycles;
+  report_.idle_cycles = statistics.idle_cycles;
+  report_.lag_frames = statistics.lag_frames;
+  report_.fused = statistics.fused;
+  return !report_.aborted;
+}
+
+RunReport HeadlessRunner::run() {
+  while (run_frame()) {
+  }
+  if (sound_worker_) {
+    sound_worker_->stop();
+    report_.sound_hash = sound_hash_;
+  }
+  return report_;
+}
+
+const RunReport& HeadlessRunner::report() const {
+  return report_;
+}
+
+const Executor& HeadlessRunner::executor() const {
+  return executor_;
+}
+
+void HeadlessRunner::apply_movie_input() {
+  const uint8_t buttons = report_.frames < movie_.size() ? movie_[report_.frames] : 0;
+  for (const auto button : magic_enum::enum_values<ControllerDevice::Button>()) {
+    executor_.controller_device().set_button(button, buttons & (1 << std::to_underlying(button)));
+  }
+}
+
+RunOptions make_run_options(const std::filesystem::path& rom_path, uint64_t frames, Accuracy accuracy) {
+  RunOptions options{.rom_path = rom_path, .frames = frames, .accuracy = accuracy};
+  if (auto path = std::filesystem::path{rom_path}.replace_extension(".movie"); std::filesystem::exists(path)) {
+    options.movie_path = std::move(path);
+  }
+  if (auto path = std::filesystem::path{rom_path}.replace_extension(".dump"); std::filesystem::exists(path)) {
+    options.savestate_path = std::move(path);
+  }
+  if (auto path = std::filesystem::path{rom_path}.replace_extension(".so"); std::filesystem::exists(path)) {
+    options.recompiled_path = std::move(path);
+  }
+  if (std::filesystem::exists(std::filesystem::path{rom_path}.replace_extension(".noidle"))) {
+    options.skip_idle_loops = false;
+  }
+  return options;
+}
+
+std::vector<std::filesystem::path> find_roms(const std::filesystem::path& directory) {
+  std::vector<std::filesystem::path> roms;
+  for (const auto& entry : std::filesystem::directory_iterator{directory}) {
+    const auto extension = entry.path().extension();
+    if (entry.is_regular_file() && (extension == ".bin" || extension == ".md" || extension == ".gen")) {
+      roms.push_back(entry.path());
+    }
+  }
+  std::ranges::sort(roms);
+  return roms;
+}
+
+} // namespace sega
@@ -0,0 +1,109 @@
+#pragma once
+#include "lib/common/util/hash.h"
+#include "lib/m68k/instruction/fusion.h"
+#include "lib/sega/executor/accuracy.h"
+#include "lib/sega/executor/executor.h"
+#include "lib/sega/memory/sound_log.h"
+#include "lib/sega/metrics/metrics.h"
+#include "lib/sega/perf/perf_counters.h"
+#include "lib/sega/sound/sound_worker.h"
+#include "lib/sega/video/video.h"
+#include "magic_enum/magic_enum.hpp"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sega {
+
+struct RunOptions {
+  std::filesystem::path rom_path;
+  uint64_t frames;
+  // one byte per frame, bit `i` is the state of `ControllerDevice::Button` with value `i`
+  std::optional<std::filesystem::path> movie_path;
+  // VDP state dump applied before the first frame
+  std::optional<std::filesystem::path> savestate_path;
+  // plugin made by `sega_recompile`
+  std::optional<std::filesystem::path> recompiled_path;
+  Accuracy accuracy{Accuracy::Fast};
+  // some games may rely on the exact number of iterations of their wait loops
+  bool skip_idle_loops{true};
+  // live counters updated after every frame, may be shared by runners
+  Metrics* metrics{};
+  // synthesizes the sound on a worker thread, the samples are hashed
+  bool sound{};
+  // hardware counters by the frame phase, the runner must run on the thread that created it then
+  bool perf{};
+};
+
+struct RunReport {
+  std::string rom_name;
+  uint64_t frames;
+  uint64_t instructions;
+  uint64_t cycles;
+  // emulated cycles skipped in idle loops
+  uint64_t idle_cycles;
+  // frames the game itself didn't finish in time, see `Executor::Statistics::lag_frames`
+  uint64_t lag_frames;
+  // instructions executed as the second of a fused pair, by the fusion kind
+  std::array<uint64_t, magic_enum::enum_count<m68k::Fusion>()> fused;
+  double host_seconds;
+  // hash of all rendered frames, equal for equal runs
+  uint64_t frame_hash;
+  // hash of all synthesized samples, zero without the sound
+  uint64_t sound_hash;
+  // the VDP phase renders the frames, the present phase hashes them
+  PerfReport perf;
+  uint64_t faults;
+  bool aborted;
+
+  double fps() const;
+  double mips() const;
+  // the share of instructions executed by fused pairs, in percents
+  double fused_percent() const;
+  // the share of emulated cycles spent in idle loops, in percents
+  double idle_percent() const;
+};
+
+// runs a ROM without a window in the deterministic emulated timing
+class HeadlessRunner {
+public:
+  HeadlessRunner(RunOptions options);
+
+  // returns false if the run is finished
+  bool run_frame();
+  RunReport run();
+  const RunReport& report() const;
+
+  const Executor& executor() const;
+
+private:
+  void apply_movie_input();
+
+private:
+  static constexpr uint64_t kMaxFaults = 1000;
+
+  const RunOptions options_;
+  Executor executor_;
+  Video video_;
+  std::vector<uint8_t> movie_;
+  std::optional<Metrics::Recorder> metrics_recorder_;
+  // the worker is declared after the log, so it's stopped before the log is destroyed
+  std::optional<SoundLog> sound_log_;
+  std::optional<SoundWorker> sound_worker_;
+  // written by the worker, read after it's stopped
+  uint64_t sound_hash_{kFnvOffsetBasis};
+  std::optional<PerfCounters> perf_counters_;
+  RunReport report_{};
+};
+
+// finds `<rom-stem>.movie`, `<rom-stem>.dump`, `<rom-stem>.so` and `<rom-stem>.noidle` files next to the ROM
+RunOptions make_run_options(const std::filesystem::path& rom_path, uint64_t frames,
+                            Accuracy accuracy = Accuracy::Fast);
+
+// returns sorted paths of all ROM files in the directory
+std::vector<std::filesystem::path> find_roms(const std::filesystem::path& directory);
+
+} // namespace sega
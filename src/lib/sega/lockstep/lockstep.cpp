@@ -0,0 +1,182 @@
+#include "lockstep.h"
+#include "fmt/format.h"
+#include "lib/common/memory/types.h"
+#include "lib/m68k/registers/registers.h"
+#include "lib/sega/executor/backend.h"
+#include "lib/sega/executor/executor.h"
+#include "lib/sega/executor/timing.h"
+#include "lib/sega/memory/bus_device.h"
+#include "spdlog/spdlog.h"
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sega {
+
+namespace {
+
+std::string diff_registers(const m68k::Registers& lhs, const m68k::Registers& rhs) {
+  std::string diff;
+  const auto add = [&diff](std::string_view name) {
+    if (!diff.empty()) {
+      diff += ' ';
+    }
+    diff += name;
+  };
+  for (int i = 0; i < 8; ++i) {
+    if (lhs.d()[i] != rhs.d()[i]) {
+      add(fmt::format("D{}", i));
+    }
+  }
+  for (int i = 0; i < 7; ++i) {
+    if (lhs.a()[i] != rhs.a()[i]) {
+      add(fmt::format("A{}", i));
+    }
+  }
+  if (lhs.usp() != rhs.usp()) {
+    add("USP");
+  }
+  if (lhs.ssp() != rhs.ssp()) {
+    add("SSP");
+  }
+  if (lhs.pc != rhs.pc) {
+    add("PC");
+  }
+  if (Word{lhs.sr} != Word{rhs.sr}) {
+    add("SR");
+  }
+  return diff;
+}
+
+void dump_writes(std::back_insert_iterator<std::string> it, const std::vector<BusDevice::Write>& writes) {
+  if (writes.empty()) {
+    fmt::format_to(it, "  no writes\n");
+  }
+  for (const auto& write : writes) {
+    fmt::format_to(it, "  {:06x} <- {}\n", write.addr, DataView{write.data});
+  }
+}
+
+} // namespace
+
+std::string Divergence::dump() const {
+  std::string result;
+  auto it = std::back_inserter(result);
+  fmt::format_to(it, "divergence after {} instructions: {}\n", instructions, reason);
+  fmt::format_to(it, "step begins at {:06x}: {} {}\n\n", step_begin.pc, step_begin.description, step_begin.bytes);
+  fmt::format_to(it, "reference registers:\n{}\n", m68k::dump(reference_registers));
+  fmt::format_to(it, "candidate registers:\n{}\n", m68k::dump(candidate_registers));
+  fmt::format_to(it, "reference writes:\n");
+  dump_writes(it, reference_writes);
+  fmt::format_to(it, "candidate writes:\n");
+  dump_writes(it, candidate_writes);
+  return result;
+}
+
+LockstepChecker::LockstepChecker(const std::filesystem::path& rom_path,
+                                 const std::optional<std::filesystem::path>& recompiled_path)
+    : reference_{rom_path.string(), Timing::Emulated, Backend::Reference},
+      candidate_{rom_path.string(), Timing::Emulated, Backend::Fast} {
+  if (recompiled_path) {
+    candidate_.load_recompiled_code(recompiled_path->string());
+  }
+  reference_.set_write_log(&reference_writes_);
+  candidate_.set_write_log(&candidate_writes_);
+}
+
+std::optional<Divergence> LockstepChecker::run(uint64_t instructions) {
+  while (candidate_.statistics().instructions < instructions) {
+    if (auto divergence = step()) {
+      return divergence;
+    }
+  }
+  return std::nullopt;
+}
+
+uint64_t LockstepChecker::instructions() const {
+  return candidate_.statistics().instructions;
+}
+
+uint64_t LockstepChecker::frames() const {
+  return candidate_.statistics().frames;
+}
+
+std::optional<Divergence> LockstepChecker::step() {
+  reference_writes_.clear();
+  candidate_writes_.clear();
+
+  const auto begin_pc = candidate_.registers().pc;
+  const auto candidate_result = candidate_.execute_current_instruction();
+  const auto candidate_instructions = candidate_.statistics().instructions;
+
+  // the interrupt is checked before the step, the reference backend may have started the frame already
+  if (candidate_result && *candidate_result == Executor::Result::VblankInterrupt) {
+    if (reference_.statistics().frames < candidate_.statistics().frames) {
+      const auto reference_result = reference_.execute_current_instruction();
+      if (!reference_result || *reference_result != Executor::Result::VblankInterrupt) {
+        return make_divergence(begin_pc, "only the candidate backend started a new frame");
+      }
+    }
+    return compare(begin_pc);
+  }
+
+  // a recompiled block is many instructions, the reference backend catches up
+  std::expected<Executor::Result, Error> reference_result = Executor::Result::Executed;
+  while (reference_.statistics().instructions < candidate_instructions) {
+    const auto reference_pc = reference_.registers().pc;
+    reference_result = reference_.execute_current_instruction();
+    if (!reference_result) {
+      break;
+    }
+    // the candidate checks interrupts between blocks, a new frame without the interrupt changes nothing
+    if (*reference_result == Executor::Result::VblankInterrupt && reference_.registers().pc != reference_pc) {
+      return make_divergence(begin_pc, "the reference backend took an interrupt inside the step");
+    }
+  }
+
+  if (candidate_result.has_value() != reference_result.has_value()) {
+    const auto& error = candidate_result ? reference_result.error() : candidate_result.error();
+    return make_divergence(begin_pc, fmt::format("only the {} backend failed: {}",
+                                                 candidate_result ? "reference" : "candidate", error.what()));
+  }
+  if (!candidate_result && candidate_result.error().what() != reference_result.error().what()) {
+    return make_divergence(begin_pc, fmt::format("the backends failed differently: \"{}\" versus \"{}\"",
+                                                 reference_result.error().what(), candidate_result.error().what()));
+  }
+  if (reference_.statistics().instructions != candidate_instructions) {
+    return make_divergence(begin_pc, fmt::format("the step ran {} instructions by the reference backend",
+                                                 reference_.statistics().instructions));
+  }
+  return compare(begin_pc);
+}
+
+std::optional<Divergence> LockstepChecker::compare(AddressType begin_pc) {
+  if (const auto diff = diff_registers(reference_.registers(), candidate_.registers()); !diff.empty()) {
+    return make_divergence(begin_pc, fmt::format("registers differ: {}", diff));
+  }
+  if (reference_writes_ != candidate_writes_) {
+    return make_divergence(begin_pc, "bus writes differ");
+  }
+  return std::nullopt;
+}
+
+Divergence LockstepChecker::make_divergence(AddressType begin_pc, std::string reason) {
+  spdlog::error("backends diverged at {:06x}: {}", begin_pc, reason);
+  return Divergence{
+      .instructions = candidate_.statistics().instructions,
+      .step_begin = reference_.instruction_info(begin_pc),
+      .reason = std::move(reason),
+      .reference_registers = reference_.registers(),
+      .candidate_registers = candidate_.registers(),
+      .reference_writes = reference_writes_,
+      .candidate_writes = candidate_writes_,
+  };
+}
+
+} // namespace sega
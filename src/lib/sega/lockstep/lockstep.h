@@ -0,0 +1,52 @@
+#pragma once
+#include "lib/m68k/registers/registers.h"
+#include "lib/sega/executor/executor.h"
+#include "lib/sega/memory/bus_device.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sega {
+
+struct Divergence {
+  // number of instructions run by both backends before the divergence
+  uint64_t instructions;
+  // the first instruction of the step, a step is one instruction or one recompiled block
+  Executor::InstructionInfo step_begin;
+  std::string reason;
+
+  m68k::Registers reference_registers;
+  m68k::Registers candidate_registers;
+  std::vector<BusDevice::Write> reference_writes;
+  std::vector<BusDevice::Write> candidate_writes;
+
+  std::string dump() const;
+};
+
+// runs the reference backend and the fast backend side by side in the emulated timing,
+// the registers and the bus writes are compared after every step of the fast backend
+class LockstepChecker {
+public:
+  LockstepChecker(const std::filesystem::path& rom_path, const std::optional<std::filesystem::path>& recompiled_path);
+
+  // returns the first divergence or nullopt if there is none in the first `instructions` instructions
+  std::optional<Divergence> run(uint64_t instructions);
+
+  uint64_t instructions() const;
+  uint64_t frames() const;
+
+private:
+  std::optional<Divergence> step();
+  std::optional<Divergence> compare(AddressType begin_pc);
+  Divergence make_divergence(AddressType begin_pc, std::string reason);
+
+private:
+  Executor reference_;
+  Executor candidate_;
+  std::vector<BusDevice::Write> reference_writes_;
+  std::vector<BusDevice::Write> candidate_writes_;
+};
+
+} // namespace sega
@@ -1,9 +1,10 @@
 #include "bus_device.h"
-#include "fmt/format.h"
 #include "lib/common/error/error.h"
 #include "lib/common/memory/device.h"
 #include "lib/common/memory/types.h"
-#include <fmt/core.h>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <optional>
 
 namespace sega {
@@ -19,15 +20,40 @@ bool range_contains(const BusDevice::Range& range, AddressType addr) {
 } // namespace
 
 void BusDevice::add_device(Range range, Device* device) {
-  mapped_devices_.emplace_back(range, device);
+  mapped_devices_.emplace_back(range, device, nullptr);
+  ++generation_;
+}
+
+void BusDevice::add_memory(Range range, Device* device, MutableDataView memory) {
+  assert(memory.size() == range.end - range.begin + 1);
+  mapped_devices_.emplace_back(range, device, memory.data());
+  ++generation_;
+}
+
+void BusDevice::set_write_log(std::vector<Write>* write_log) {
+  write_log_ = write_log;
+}
+
+void BusDevice::add_direct_writes(AddressType addr, DataView data, size_t size) {
+  write_count_ += data.size() / size;
+  if (write_log_) [[unlikely]] {
+    for (size_t i = 0; i < data.size(); i += size) {
+      write_log_->push_back({.addr = (addr + i) & kAddressMask, .data = {data.begin() + i, data.begin() + i + size}});
+    }
+  }
 }
 
 std::optional<Error> BusDevice::read(AddressType addr, MutableDataView data) {
   addr &= kAddressMask;
-  if (auto* mapped_device = find_by_addr(addr)) {
+  const auto* mapped_device = inline_cache_ ? find_cached(inline_cache_->read, addr) : find_by_addr(addr);
+  if (mapped_device) {
+    if (mapped_device->memory && addr + data.size() - 1 <= mapped_device->range.end) {
+      std::memcpy(data.data(), mapped_device->memory + (addr - mapped_device->range.begin), data.size());
+      return std::nullopt;
+    }
     return mapped_device->device->read(addr, data);
   }
-  return Error{Error::UnmappedRead, fmt::format("unmapped read address: {:06x} size: {:x}", addr, data.size())};
+  return Error{Error::UnmappedRead, "unmapped read address: {:06x} size: {:x}", addr, data.size()};
 }
 
 std::optional<Error> BusDevice::write(AddressType addr, DataView data) {
@@ -35,14 +61,23 @@ std::optional<Error> BusDevice::write(AddressType addr, DataView data) {
     return std::nullopt;
   }
   addr &= kAddressMask;
-  if (auto* mapped_device = find_by_addr(addr)) {
+  ++write_count_;
+  if (write_log_) [[unlikely]] {
+    write_log_->push_back({.addr = addr, .data = {data.begin(), data.end()}});
+  }
+  const auto* mapped_device = inline_cache_ ? find_cached(inline_cache_->write, addr) : find_by_addr(addr);
+  if (mapped_device) {
+    if (mapped_device->memory && addr + data.size() - 1 <= mapped_device->range.end) {
+      std::memcpy(mapped_device->memory + (addr - mapped_device->range.begin), data.data(), data.size());
+      return std::nullopt;
+    }
     return mapped_device->device->write(addr, data);
   }
-  return Error{Error::UnmappedWrite, fmt::format("unmapped write address: {:06x} size: {:x}", addr, data.size())};
+  return Error{Error::UnmappedWrite, "unmapped write address: {:06x} size: {:x}", addr, data.size()};
 }
 
-BusDevice::MappedDevice* BusDevice::find_by_addr(AddressType addr) {
-  for (auto& record : mapped_devices_) {
+const BusDevice::MappedDevice* BusDevice::find_by_addr(AddressType addr) const {
+  for (const auto& record : mapped_devices_) {
     if (range_contains(record.range, addr)) {
       return &record;
     }
@@ -50,4 +85,15 @@ BusDevice::MappedDevice* BusDevice::find_by_addr(AddressType addr) {
   return nullptr;
 }
 
+const BusDevice::MappedDevice* BusDevice::find_cached(InlineCacheEntry& entry, AddressType addr) const {
+  if (entry.generation == generation_ && range_contains(entry.mapped_device->range, addr)) [[likely]] {
+    return entry.mapped_device;
+  }
+  const auto* mapped_device = find_by_addr(addr);
+  if (mapped_device) {
+    entry = {.generation = generation_, .mapped_device = mapped_device};
+  }
+  return mapped_device;
+}
+
 } // namespace sega
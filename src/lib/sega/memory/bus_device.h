@@ -2,6 +2,8 @@
 #include "lib/common/error/error.h"
 #include "lib/common/memory/device.h"
 #include "lib/common/memory/types.h"
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <vector>
 
@@ -14,6 +16,35 @@ public:
     AddressType end;
   };
 
+  struct Write {
+    AddressType addr;
+    std::vector<Byte> data;
+
+    bool operator==(const Write&) const = default;
+  };
+
+private:
+  struct MappedDevice {
+    const Range range;
+    Device* device;
+    // the memory of a plain memory device, accessed without calling the device
+    Byte* memory;
+  };
+
+public:
+  // the device resolved by the last access, valid while the device mapping has the same generation
+  struct InlineCacheEntry {
+    uint32_t generation;
+    const MappedDevice* mapped_device;
+  };
+
+  // the devices resolved by the reads and the writes of one instruction,
+  // its accesses usually go to the same device on every execution
+  struct InlineCache {
+    InlineCacheEntry read;
+    InlineCacheEntry write;
+  };
+
 public:
   void add_device(Range range, Device* device);
 
@@ -27,20 +58,39 @@ public:
     add_device({T::kBegin, T::kEnd}, device);
   }
 
-private:
-  struct MappedDevice {
-    const Range range;
-    Device* device;
-  };
+  // the device is plain memory of the range size, the bus reads and writes `memory` directly
+  void add_memory(Range range, Device* device, MutableDataView memory);
+
+  // accesses are resolved through the cache until it's reset to nullptr
+  void set_inline_cache(InlineCache* inline_cache) {
+    inline_cache_ = inline_cache;
+  }
+
+  // all writes are appended to the log until it's reset to nullptr
+  void set_write_log(std::vector<Write>* write_log);
+
+  // accounts the writes made directly into the memory of a device, `data` is split into writes of `size` bytes
+  void add_direct_writes(AddressType addr, DataView data, size_t size);
+
+  // the number of all writes, the memory didn't change if it's the same
+  uint64_t write_count() const {
+    return write_count_;
+  }
 
 private:
   std::optional<Error> read(AddressType addr, MutableDataView data) override;
   std::optional<Error> write(AddressType addr, DataView data) override;
 
-  MappedDevice* find_by_addr(AddressType addr);
+  const MappedDevice* find_by_addr(AddressType addr) const;
+  const MappedDevice* find_cached(InlineCacheEntry& entry, AddressType addr) const;
 
 private:
   std::vector<MappedDevice> mapped_devices_;
+  // incremented when the mapping changes, zero is never valid
+  uint32_t generation_{1};
+  InlineCache* inline_cache_{};
+  std::vector<Write>* write_log_{};
+  uint64_t write_count_{};
 };
 
 } // namespace sega
@@ -90,6 +90,26 @@ void ControllerDevice::set_button(Button button, bool pressed) {
   pressed_map[std::to_underlying(button)] = pressed;
 }
 
+bool ControllerDevice::take_polled() {
+  return std::exchange(polled_, false);
+}
+
+void ControllerDevice::save_state(State& state) const {
+  state = {
+      .pressed_map_by_controller = pressed_map_by_controller_,
+      .current_step_by_controller = current_step_by_controller_,
+      .ctrl_value = ctrl_value_,
+      .polled = polled_,
+  };
+}
+
+void ControllerDevice::load_state(const State& state) {
+  pressed_map_by_controller_ = state.pressed_map_by_controller;
+  current_step_by_controller_ = state.current_step_by_controller;
+  ctrl_value_ = state.ctrl_value;
+  polled_ = state.polled;
+}
+
 std::optional<Error> ControllerDevice::read(AddressType addr, MutableDataView data) {
   for (size_t i = 0; i < data.size(); ++i) {
     auto& value = data[i];
@@ -175,6 +195,7 @@ Byte ControllerDevice::read_version() {
 }
 
 Byte ControllerDevice::read_pressed_status(size_t controller) {
+  polled_ = true;
   const auto& pressed_map = pressed_map_by_controller_[controller];
   const auto& current_step = current_step_by_controller_[controller];
   switch (current_step) {
@@ -29,6 +29,9 @@ public:
   // only for 0th controller currently
   void set_button(Button button, bool pressed);
 
+  // returns if a data port was read since the previous call
+  bool take_polled();
+
 private:
   std::optional<Error> read(AddressType addr, MutableDataView data) override;
   std::optional<Error> write(AddressType addr, DataView data) override;
@@ -46,10 +49,23 @@ private:
     Step2,
   };
 
+public:
+  // the state restored in place by the executor reset
+  struct State {
+    std::array<PressedMap, kControllersCount> pressed_map_by_controller;
+    std::array<StepNumber, kControllersCount> current_step_by_controller;
+    std::array<Byte, kControllersCount> ctrl_value;
+    bool polled;
+  };
+
+  void save_state(State& state) const;
+  void load_state(const State& state);
+
 private:
   std::array<PressedMap, kControllersCount> pressed_map_by_controller_{};
   std::array<StepNumber, kControllersCount> current_step_by_controller_{};
   std::array<Byte, kControllersCount> ctrl_value_{};
+  bool polled_{};
 };
 
 } // namespace sega
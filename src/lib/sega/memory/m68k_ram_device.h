@@ -14,6 +14,14 @@ public:
 
   M68kRamDevice();
 
+  // direct access for bulk transfers, the first byte is at `kBegin`
+  MutableDataView data() {
+    return data_;
+  }
+  DataView data() const {
+    return data_;
+  }
+
 private:
   std::optional<Error> read(AddressType addr, MutableDataView data) override;
   std::optional<Error> write(AddressType addr, DataView data) override;
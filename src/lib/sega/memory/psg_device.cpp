@@ -1,13 +1,24 @@
 #include "psg_device.h"
 #include "lib/common/error/error.h"
 #include "lib/common/memory/types.h"
+#include "lib/sega/memory/sound_log.h"
+#include <cstdint>
 #include <optional>
 #include <spdlog/spdlog.h>
 
 namespace sega {
 
+PsgDevice::PsgDevice(const uint64_t& cycles) : cycles_{cycles} {}
+
+void PsgDevice::set_sound_log(SoundLog* sound_log) {
+  sound_log_ = sound_log;
+}
+
 std::optional<Error> PsgDevice::write(AddressType addr, DataView data) {
   spdlog::debug("write to PSG device byte: {:02x}", data.as<Byte>());
+  if (sound_log_) {
+    sound_log_->append({.cycles = cycles_, .chip = SoundWrite::Chip::Psg, .address = 0, .value = data.as<Byte>()});
+  }
   return std::nullopt;
 }
 
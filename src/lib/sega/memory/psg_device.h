@@ -2,6 +2,8 @@
 #include "lib/common/error/error.h"
 #include "lib/common/memory/device.h"
 #include "lib/common/memory/types.h"
+#include "lib/sega/memory/sound_log.h"
+#include <cstdint>
 #include <optional>
 
 namespace sega {
@@ -11,8 +13,18 @@ public:
   static constexpr AddressType kBegin = 0xC00011;
   static constexpr AddressType kEnd = 0xC00012;
 
+  // `cycles` is the emulated time of the writes
+  PsgDevice(const uint64_t& cycles);
+
+  // the writes are appended to the log until it's reset to nullptr
+  void set_sound_log(SoundLog* sound_log);
+
 private:
   std::optional<Error> write(AddressType addr, DataView data) override;
+
+private:
+  const uint64_t& cycles_;
+  SoundLog* sound_log_{};
 };
 
 } // namespace sega
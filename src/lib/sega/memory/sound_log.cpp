@@ -0,0 +1,53 @@
+#include "sound_log.h"
+#include <atomic>
+#include <cstdint>
+
+namespace sega {
+
+SoundLog::SoundLog() {
+  for (auto& frame : frames_) {
+    frame.writes.reserve(kReservedWrites);
+  }
+}
+
+bool SoundLog::end_frame(uint64_t cycles) {
+  const auto head = head_.load(std::memory_order_relaxed);
+  frames_[head % kFrames].end_cycles = cycles;
+  if (head + 1 - tail_.load(std::memory_order_acquire) >= kFrames) {
+    open_frame_ended_ = true;
+    return false;
+  }
+  open_frame_ended_ = false;
+  head_.store(head + 1, std::memory_order_release);
+  head_.notify_one();
+  return true;
+}
+
+const SoundLog::Frame* SoundLog::wait_frame() {
+  const auto tail = tail_.load(std::memory_order_relaxed);
+  while (true) {
+    const auto head = head_.load(std::memory_order_acquire);
+    if ((head & ~kStopped) != tail) {
+      return &frames_[tail % kFrames];
+    }
+    if (head & kStopped) {
+      return nullptr;
+    }
+    head_.wait(head, std::memory_order_acquire);
+  }
+}
+
+void SoundLog::pop_frame() {
+  const auto tail = tail_.load(std::memory_order_relaxed);
+  frames_[tail % kFrames].writes.clear();
+  tail_.store(tail + 1, std::memory_order_release);
+}
+
+void SoundLog::stop() {
+  // the open frame isn't appended anymore, so it's handed over even if the worker is reading all other frames
+  const auto head = head_.load(std::memory_order_relaxed) + (open_frame_ended_ ? 1 : 0);
+  head_.store(head | kStopped, std::memory_order_release);
+  head_.notify_one();
+}
+
+} // namespace sega
@@ -0,0 +1,73 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sega {
+
+// a register write of a sound chip at the emulated time
+struct SoundWrite {
+  enum class Chip : uint8_t {
+    Psg,
+    Ym2612Part1,
+    Ym2612Part2,
+    // not a write: the emulation was reset, the chips are at power-on and the time restarts at `cycles`
+    Reset,
+  };
+
+  uint64_t cycles;
+  Chip chip;
+  // the latched register, zero for the PSG
+  Byte address;
+  Byte value;
+};
+
+// the sound chip writes split into frames, the emulation thread appends the writes and ends the frames,
+// a worker thread takes the ended frames; the frames are handed over without locks, so the emulation never waits
+class SoundLog {
+public:
+  struct Frame {
+    std::vector<SoundWrite> writes;
+    // the emulated time of the frame end
+    uint64_t end_cycles;
+  };
+
+  SoundLog();
+
+  // the emulation thread
+  void append(const SoundWrite& write) {
+    frames_[head_.load(std::memory_order_relaxed) % kFrames].writes.push_back(write);
+  }
+  // the emulated time may go back after the reset, the worker restarts its time base then
+  void reset(uint64_t cycles) {
+    append({.cycles = cycles, .chip = SoundWrite::Chip::Reset, .address = 0, .value = 0});
+  }
+  // returns false if the worker is behind, the writes stay in the open frame then and are ended with the next one
+  bool end_frame(uint64_t cycles);
+
+  // the worker thread, `wait_frame` returns nullptr when all frames ended before `stop` are taken
+  const Frame* wait_frame();
+  void pop_frame();
+  // called by the emulation thread after the last frame, the frame ended last is handed over too
+  void stop();
+
+private:
+  static constexpr size_t kFrames = 4;
+  // enough for the music of a frame, the buffers grow if needed and are reused
+  static constexpr size_t kReservedWrites = 1024;
+
+  // set in `head_`, so the waiting worker sees the change
+  static constexpr uint64_t kStopped = uint64_t{1} << 63;
+
+  std::array<Frame, kFrames> frames_;
+  // the open frame is `head_`, the ended frames are from `tail_` to `head_`
+  std::atomic<uint64_t> head_{};
+  std::atomic<uint64_t> tail_{};
+  // the last `end_frame` failed, only the emulation thread uses it
+  bool open_frame_ended_{};
+};
+
+} // namespace sega
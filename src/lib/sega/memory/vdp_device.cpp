@@ -1,5 +1,4 @@
 #include "vdp_device.h"
-#include "fmt/format.h"
 #include "lib/common/error/error.h"
 #include "lib/common/memory/device.h"
 #include "lib/common/memory/types.h"
@@ -12,7 +11,6 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
-#include <fmt/core.h>
 #include <functional>
 #include <iterator>
 #include <optional>
@@ -317,6 +315,39 @@ void VdpDevice::apply_state(Passkey<StateDump>, DataView state) {
   }
 }
 
+void VdpDevice::save_state(State& state) const {
+  state.registers.assign(registers_.begin(), registers_.end());
+  state.vram_data.assign(vram_data_.begin(), vram_data_.end());
+  state.vsram_data.assign(vsram_data_.begin(), vsram_data_.end());
+  state.cram_data.assign(cram_data_.begin(), cram_data_.end());
+  state.first_half = first_half_;
+  state.use_dma = use_dma_;
+  state.ram_kind = std::to_underlying(ram_kind_);
+  state.ram_address = ram_address_;
+  state.beam = beam_;
+}
+
+void VdpDevice::load_state(const State& state) {
+  // the state must be saved by this device, e.g. not be a default snapshot
+  assert(state.registers.size() == registers_.size());
+  assert(state.vram_data.size() == vram_data_.size());
+  assert(state.vsram_data.size() == vsram_data_.size());
+  assert(state.cram_data.size() == cram_data_.size());
+  // the fields decoded from the registers are set by processing them again
+  for (Byte reg = std::to_underlying(VdpRegister::First), i = 0; reg <= std::to_underlying(VdpRegister::Last);
+       ++reg, ++i) {
+    std::ignore = process_vdp_register((Word{reg} << 8) | state.registers[i]);
+  }
+  std::memcpy(vram_data_.data(), state.vram_data.data(), vram_data_.size());
+  std::memcpy(vsram_data_.data(), state.vsram_data.data(), vsram_data_.size());
+  std::memcpy(cram_data_.data(), state.cram_data.data(), cram_data_.size());
+  first_half_ = state.first_half;
+  use_dma_ = state.use_dma;
+  ram_kind_ = static_cast<RamKind>(state.ram_kind);
+  ram_address_ = state.ram_address;
+  beam_ = state.beam;
+}
+
 std::optional<Error> VdpDevice::read(AddressType addr, MutableDataView data) {
   if (data.size() == 1) [[unlikely]] {
     --addr;
@@ -346,15 +377,15 @@ std::optional<Error> VdpDevice::read(AddressType addr, MutableDataView data) {
       break;
     }
     case (kHvCounter1 - 1)... kHvCounter4: {
-      // just fill with zeros now
-      data[i] = 0;
+      // zeros if the beam isn't tracked
+      data[i] = beam_ ? beam_->v_counter : 0;
       if (data.size() > 1) {
-        data[i + 1] = 0;
+        data[i + 1] = beam_ ? beam_->h_counter : 0;
       }
       break;
     }
     default:
-      return Error{Error::InvalidRead, fmt::format("Invalid VDP read address: {:06x} size: {}", addr, data.size())};
+      return Error{Error::InvalidRead, "Invalid VDP read address: {:06x} size: {}", addr, data.size()};
     }
   }
 
@@ -378,7 +409,7 @@ std::optional<Error> VdpDevice::write(AddressType addr, DataView data) {
       }
       break;
     default:
-      return Error{Error::InvalidWrite, fmt::format("invalid VDP write address: {:06x} size: {}", addr, data.size())};
+      return Error{Error::InvalidWrite, "invalid VDP write address: {:06x} size: {}", addr, data.size()};
     }
   }
 
@@ -422,7 +453,7 @@ std::optional<Error> VdpDevice::process_vdp_control(Word command) {
       ram_kind_ = RamKind::Vsram;
       break;
     default:
-      return Error{Error::InvalidWrite, fmt::format("Invalid RAM kind value: {:08x}", value)};
+      return Error{Error::InvalidWrite, "Invalid RAM kind value: {:08x}", value};
     }
     const bool is_write = (mask == 0b0001) || (mask == 0b0011) || (mask == 0b0101);
 
@@ -430,7 +461,7 @@ std::optional<Error> VdpDevice::process_vdp_control(Word command) {
                   magic_enum::enum_name(ram_kind_), use_dma_, is_write);
 
     if (use_dma_ && dma_type_ == DmaType::VramCopy) {
-      return Error{Error::InvalidWrite, fmt::format("Unsupported DMA type yet: {:08x}", value)};
+      return Error{Error::InvalidWrite, "Unsupported DMA type yet: {:08x}", value};
     }
 
     if (use_dma_ && dma_type_ == DmaType::MemoryToVram) {
@@ -442,6 +473,7 @@ std::optional<Error> VdpDevice::process_vdp_control(Word command) {
           magic_enum::enum_name(ram_kind_), source_start, len, ram_address_, auto_increment_);
 
       auto& ram = ram_data();
+      dma_bytes_ += len;
       if (auto_increment_ == 2) {
         // can do fast DMA, just whole block of memory
         const auto safe_len = std::min(len, static_cast<Long>(ram.size() - ram_address_));
@@ -487,6 +519,7 @@ std::optional<Error> VdpDevice::process_vdp_data(Word data) {
       }
     }
 
+    dma_bytes_ += len;
     for (size_t i = 0; i < len; ++i) {
       ram[ram_address_] = data & 0xFF;
       ram_address_ += auto_increment_;
@@ -574,7 +607,7 @@ std::optional<Error> VdpDevice::process_vdp_register(Word data) {
   case VdpRegister::Unused8E:
     break;
   default:
-    return Error{Error::InvalidWrite, fmt::format("Invalid VDP register command: {:02x}", data)};
+    return Error{Error::InvalidWrite, "Invalid VDP register command: {:02x}", data};
   }
   registers_[kind - std::to_underlying(VdpRegister::First)] = value;
   return std::nullopt;
@@ -582,6 +615,7 @@ std::optional<Error> VdpDevice::process_vdp_register(Word data) {
 
 void VdpDevice::process_mode1_set(Byte value) {
   const auto mode1 = std::bit_cast<Mode1>(value);
+  hblank_interrupt_enabled_ = mode1.enable_hblank_interrupt;
   spdlog::debug("mode1 set disable_display: {} freeze_hv_counter: {} dont_mask_high_bit_of_color_entries: {} "
                 "enable_hblank_interrupt: {} blank_leftmost_column: {}",
                 mode1.disable_display, mode1.freeze_hv_counter, mode1.dont_mask_high_bit_of_color_entries,
@@ -638,6 +672,7 @@ void VdpDevice::process_background_color(Byte value) {
 }
 
 void VdpDevice::process_hblank_interrupt_rate(Byte value) {
+  hblank_interrupt_rate_ = value;
   spdlog::debug("hblank interrupt rate: {}", value);
 }
 
@@ -768,7 +803,7 @@ Word VdpDevice::read_status_register() {
       .mode = StatusRegister::Mode::NTSC,
       .dma_status = StatusRegister::DmaStatus::NotBusy,
       .hblank_status = StatusRegister::HblankStatus::NotInHblank,
-      .vblank_status = StatusRegister::VblankStatus::InVblank, // TODO: provide correct value
+      .vblank_status = StatusRegister::VblankStatus::InVblank, // the beam isn't tracked, see `set_beam`
       .frame_status = StatusRegister::FrameStatus::EvenFrame,
       .collision_status = StatusRegister::CollisionStatus::NoCollision,
       .sprites_overflow_status = StatusRegister::SpritesOverflowStatus::NoSpritesOverflow,
@@ -776,7 +811,19 @@ Word VdpDevice::read_status_register() {
       .fifo_full_status = StatusRegister::FifoFullStatus::FifoNotFull,
       .fifo_empty_status = StatusRegister::FifoEmptyStatus::FifoNotEmpty,
   };
-  return std::bit_cast<Word>(kStatusRegister);
+  if (!beam_) {
+    return std::bit_cast<Word>(kStatusRegister);
+  }
+  auto status_register = kStatusRegister;
+  status_register.vblank_status =
+      beam_->in_vblank ? StatusRegister::VblankStatus::InVblank : StatusRegister::VblankStatus::NotInVblank;
+  status_register.hblank_status =
+      beam_->in_hblank ? StatusRegister::HblankStatus::InHblank : StatusRegister::HblankStatus::NotInHblank;
+  return std::bit_cast<Word>(status_register);
+}
+
+void VdpDevice::set_beam(Beam beam) {
+  beam_ = beam;
 }
 
 std::vector<Byte>& VdpDevice::ram_data() {
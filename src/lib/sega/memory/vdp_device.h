@@ -32,6 +32,14 @@ public:
     Y,
   };
 
+  // the position of the beam is known only in the accurate tier
+  struct Beam {
+    Byte v_counter;
+    Byte h_counter;
+    bool in_vblank;
+    bool in_hblank;
+  };
+
 public:
   VdpDevice(Device& bus_device);
 
@@ -39,6 +47,16 @@ public:
   bool vblank_interrupt_enabled() const {
     return vblank_interrupt_enabled_;
   }
+  bool hblank_interrupt_enabled() const {
+    return hblank_interrupt_enabled_;
+  }
+  // HBLANK interrupt happens every `hblank_interrupt_rate() + 1` lines
+  Byte hblank_interrupt_rate() const {
+    return hblank_interrupt_rate_;
+  }
+
+  // the status register and the HV counter report the beam after it's set
+  void set_beam(Beam beam);
 
   uint8_t tile_width() const {
     return width_;
@@ -109,10 +127,30 @@ public:
     return cram_data_;
   }
 
+  // bytes written to the video RAMs by DMA since the start
+  uint64_t dma_bytes() const {
+    return dma_bytes_;
+  }
+
   // dump or apply whole VDP state
   std::vector<Byte> dump_state(Passkey<class StateDump>) const;
   void apply_state(Passkey<StateDump>, DataView state);
 
+  // the state restored in place by the executor reset, the buffers are reused after the first save
+  struct State {
+    std::vector<Byte> registers;
+    std::vector<Byte> vram_data;
+    std::vector<Byte> vsram_data;
+    std::vector<Byte> cram_data;
+    std::optional<Word> first_half;
+    bool use_dma;
+    uint8_t ram_kind;
+    Word ram_address;
+    std::optional<Beam> beam;
+  };
+  void save_state(State& state) const;
+  void load_state(const State& state);
+
 private:
   std::optional<Error> read(AddressType addr, MutableDataView data) override;
   std::optional<Error> write(AddressType addr, DataView data) override;
@@ -162,6 +200,8 @@ private:
 private:
   // data from registers
   bool vblank_interrupt_enabled_{};
+  bool hblank_interrupt_enabled_{};
+  Byte hblank_interrupt_rate_{};
 
   bool allow_dma_{};
   Long dma_length_words_{}; // warning - size in words, not in bytes
@@ -207,6 +247,12 @@ private:
   std::vector<Byte> vsram_data_;
   std::vector<Byte> cram_data_;
 
+  // beam position
+  std::optional<Beam> beam_;
+
+  // counters
+  uint64_t dma_bytes_{};
+
   // memory bus device
   Device& bus_device_;
 };
@@ -1,22 +1,144 @@
 #include "ym2612_device.h"
 #include "lib/common/error/error.h"
 #include "lib/common/memory/types.h"
+#include "lib/sega/memory/sound_log.h"
 #include "spdlog/spdlog.h"
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 
+// reference: https://www.plutiedev.com/ym2612-registers
+
 namespace sega {
 
+namespace {
+
+// the chip makes a sample every 144 cycles of its clock, which is the 68000 clock
+constexpr uint64_t kSampleCycles = 144;
+// a data write keeps the chip busy for 32 cycles of its internal clock, it's 6 times slower
+constexpr uint64_t kBusyCycles = 32 * 6;
+
+constexpr size_t kTimerA = 0;
+constexpr size_t kTimerB = 1;
+
+constexpr Byte kTimerAHighRegister = 0x24;
+constexpr Byte kTimerALowRegister = 0x25;
+constexpr Byte kTimerBRegister = 0x26;
+constexpr Byte kTimerControlRegister = 0x27;
+
+constexpr Byte kBusyFlag = 0x80;
+
+} // namespace
+
+Ym2612Device::Ym2612Device(const uint64_t& cycles) : cycles_{cycles} {
+  timers_[kTimerA].period = 1024 * kSampleCycles;
+  timers_[kTimerB].period = 256 * 16 * kSampleCycles;
+}
+
+void Ym2612Device::set_sound_log(SoundLog* sound_log) {
+  sound_log_ = sound_log;
+}
+
+void Ym2612Device::save_state(State& state) const {
+  state = {
+      .address = address_,
+      .timer_a_value = timer_a_value_,
+      .timers = timers_,
+      .busy_until = busy_until_,
+  };
+}
+
+void Ym2612Device::load_state(const State& state) {
+  address_ = state.address;
+  timer_a_value_ = state.timer_a_value;
+  timers_ = state.timers;
+  busy_until_ = state.busy_until;
+}
+
 std::optional<Error> Ym2612Device::read(AddressType addr, MutableDataView data) {
-  spdlog::debug("write to YM2612 device address: {:06x} size: {}", addr, data.size());
+  // every port reads the status
+  update_timers();
+  Byte status = cycles_ < busy_until_ ? kBusyFlag : 0;
+  for (size_t i = 0; i < timers_.size(); ++i) {
+    status |= timers_[i].overflowed << i;
+  }
   for (auto& value : data) {
-    value = 0;
+    value = status;
   }
   return std::nullopt;
 }
 
 std::optional<Error> Ym2612Device::write(AddressType addr, DataView data) {
-  spdlog::debug("write to YM2612 device address: {:06x} byte: {:02x}", addr, data.as<Byte>());
+  // a word writes the address and the data at once
+  for (size_t i = 0; i < data.size(); ++i) {
+    const auto port = (addr + i - kBegin) % 4;
+    const auto part = port / 2;
+    if (port % 2 == 0) {
+      address_[part] = data[i];
+    } else {
+      write_register(part, address_[part], data[i]);
+    }
+  }
   return std::nullopt;
 }
 
+void Ym2612Device::write_register(size_t part, Byte address, Byte value) {
+  spdlog::debug("YM2612 part {} register {:02x} value {:02x}", part + 1, address, value);
+  busy_until_ = cycles_ + kBusyCycles;
+  if (sound_log_) {
+    sound_log_->append({
+        .cycles = cycles_,
+        .chip = part == 0 ? SoundWrite::Chip::Ym2612Part1 : SoundWrite::Chip::Ym2612Part2,
+        .address = address,
+        .value = value,
+    });
+  }
+  if (part != 0) {
+    return;
+  }
+
+  // the timers count the samples, the timer A every sample and the timer B every 16 samples
+  switch (address) {
+  case kTimerAHighRegister:
+    timer_a_value_ = (timer_a_value_ & 0x3) | (uint16_t{value} << 2);
+    timers_[kTimerA].period = (1024 - timer_a_value_) * kSampleCycles;
+    break;
+  case kTimerALowRegister:
+    timer_a_value_ = (timer_a_value_ & ~0x3) | (value & 0x3);
+    timers_[kTimerA].period = (1024 - timer_a_value_) * kSampleCycles;
+    break;
+  case kTimerBRegister:
+    timers_[kTimerB].period = (256 - value) * 16 * kSampleCycles;
+    break;
+  case kTimerControlRegister:
+    update_timers();
+    for (size_t i = 0; i < timers_.size(); ++i) {
+      auto& timer = timers_[i];
+      const bool load = value & (1 << i);
+      if (load && !timer.running) {
+        timer.next_overflow = cycles_ + timer.period;
+      }
+      timer.running = load;
+      timer.flag_enabled = value & (1 << (i + 2));
+      if (value & (1 << (i + 4))) {
+        timer.overflowed = false;
+      }
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void Ym2612Device::update_timers() {
+  for (auto& timer : timers_) {
+    if (!timer.running || cycles_ < timer.next_overflow) {
+      continue;
+    }
+    // the timer is reloaded on every overflow
+    timer.overflowed |= timer.flag_enabled;
+    timer.next_overflow += ((cycles_ - timer.next_overflow) / timer.period + 1) * timer.period;
+  }
+}
+
 } // namespace sega
@@ -2,18 +2,62 @@
 #include "lib/common/error/error.h"
 #include "lib/common/memory/device.h"
 #include "lib/common/memory/types.h"
+#include "lib/sega/memory/sound_log.h"
+#include <array>
+#include <cstdint>
 #include <optional>
 
 namespace sega {
 
+// keeps only the state read back by the CPU, i.e. the busy flag and the timers,
+// the register writes are synthesized from the sound log by a worker
 class Ym2612Device : public Device {
 public:
   static constexpr AddressType kBegin = 0xA04000;
   static constexpr AddressType kEnd = 0xA04003;
 
+  struct Timer {
+    // in the emulated cycles
+    uint64_t period;
+    uint64_t next_overflow;
+    bool running;
+    bool flag_enabled;
+    bool overflowed;
+  };
+
+  // the state restored in place by the executor reset
+  struct State {
+    std::array<Byte, 2> address;
+    uint16_t timer_a_value;
+    std::array<Timer, 2> timers;
+    uint64_t busy_until;
+  };
+
+  // `cycles` is the emulated time of the accesses
+  Ym2612Device(const uint64_t& cycles);
+
+  // the writes are appended to the log until it's reset to nullptr
+  void set_sound_log(SoundLog* sound_log);
+
+  void save_state(State& state) const;
+  void load_state(const State& state);
+
 private:
   std::optional<Error> read(AddressType addr, MutableDataView data) override;
   std::optional<Error> write(AddressType addr, DataView data) override;
+
+  void write_register(size_t part, Byte address, Byte value);
+  void update_timers();
+
+private:
+  const uint64_t& cycles_;
+  SoundLog* sound_log_{};
+
+  // the latched register of each part
+  std::array<Byte, 2> address_{};
+  uint16_t timer_a_value_{};
+  std::array<Timer, 2> timers_{};
+  uint64_t busy_until_{};
 };
 
 } // namespace sega
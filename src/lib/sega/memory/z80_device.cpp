@@ -1,10 +1,10 @@
 #include "z80_device.h"
-#include "fmt/format.h"
 #include "lib/common/error/error.h"
 #include "lib/common/memory/types.h"
 #include <algorithm>
+#include <cassert>
 #include <cstddef>
-#include <fmt/core.h>
+#include <cstring>
 #include <functional>
 #include <optional>
 #include <spdlog/spdlog.h>
@@ -23,6 +23,17 @@ Z80RamDevice::Z80RamDevice() {
   ram_data_.resize(kRamSize);
 }
 
+void Z80RamDevice::save_state(State& state) const {
+  state.ram_data.assign(ram_data_.begin(), ram_data_.end());
+  state.random_engine = random_engine_;
+}
+
+void Z80RamDevice::load_state(const State& state) {
+  assert(state.ram_data.size() == ram_data_.size());
+  std::memcpy(ram_data_.data(), state.ram_data.data(), ram_data_.size());
+  random_engine_ = state.random_engine;
+}
+
 std::optional<Error> Z80RamDevice::read(AddressType addr, MutableDataView data) {
   std::generate(data.begin(), data.end(), std::ref(random_engine_));
   return std::nullopt;
@@ -35,6 +46,14 @@ std::optional<Error> Z80RamDevice::write(AddressType addr, DataView data) {
   return std::nullopt;
 }
 
+void Z80ControllerDevice::save_state(State& state) const {
+  state.bus_value = bus_value_;
+}
+
+void Z80ControllerDevice::load_state(const State& state) {
+  bus_value_ = state.bus_value;
+}
+
 std::optional<Error> Z80ControllerDevice::read(AddressType addr, MutableDataView data) {
   if (data.size() == 2 && addr == kZ80BusRequest) {
     spdlog::debug("Z80 bus request read: {:04x}", bus_value_);
@@ -48,8 +67,7 @@ std::optional<Error> Z80ControllerDevice::read(AddressType addr, MutableDataView
     data[0] = bus_value_ >> 8;
     return std::nullopt;
   }
-  return Error{Error::UnmappedRead,
-               fmt::format("Unmapped z80 controller read address: {:06x} size: {:x}", addr, data.size())};
+  return Error{Error::UnmappedRead, "Unmapped z80 controller read address: {:06x} size: {:x}", addr, data.size()};
 }
 
 std::optional<Error> Z80ControllerDevice::write(AddressType addr, DataView data) {
@@ -64,8 +82,7 @@ std::optional<Error> Z80ControllerDevice::write(AddressType addr, DataView data)
     spdlog::debug("Z80 reset write: {:04x}", value);
     return std::nullopt;
   }
-  return Error{Error::UnmappedWrite,
-               fmt::format("Unmapped z80 controller write address: {:06x} size: {:x}", addr, data.size())};
+  return Error{Error::UnmappedWrite, "Unmapped z80 controller write address: {:06x} size: {:x}", addr, data.size()};
 }
 
 } // namespace sega
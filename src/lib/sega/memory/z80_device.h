@@ -13,10 +13,18 @@ public:
   static constexpr AddressType kBegin = 0xA00000;
   static constexpr AddressType kEnd = 0xA0FFFF;
 
+  using RandomBytesEngine = std::independent_bits_engine<std::default_random_engine, 8, Byte>;
+
+  // the state restored in place by the executor reset, the buffer is reused after the first save
+  struct State {
+    std::vector<Byte> ram_data;
+    RandomBytesEngine random_engine;
+  };
+
   Z80RamDevice();
 
-private:
-  using RandomBytesEngine = std::independent_bits_engine<std::default_random_engine, 8, Byte>;
+  void save_state(State& state) const;
+  void load_state(const State& state);
 
 private:
   std::optional<Error> read(AddressType addr, MutableDataView data) override;
@@ -32,6 +40,13 @@ public:
   static constexpr AddressType kBegin = 0xA11100;
   static constexpr AddressType kEnd = 0xA11201;
 
+  struct State {
+    Word bus_value;
+  };
+
+  void save_state(State& state) const;
+  void load_state(const State& state);
+
 private:
   std::optional<Error> read(AddressType addr, MutableDataView data) override;
   std::optional<Error> write(AddressType addr, DataView data) override;
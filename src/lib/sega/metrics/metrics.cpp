@@ -0,0 +1,70 @@
+#include "metrics.h"
+#include "lib/sega/executor/executor.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace sega {
+
+namespace {
+
+constexpr auto kFramePeriod = std::chrono::duration<double>{1.0 / 60};
+
+void add(std::atomic<uint64_t>& counter, uint64_t value) {
+  if (value > 0) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+  }
+}
+
+uint64_t load(const std::atomic<uint64_t>& counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+Metrics::Recorder::Recorder(Metrics& metrics, const Executor& executor)
+    : metrics_{metrics}, executor_{executor}, previous_{executor.statistics()},
+      previous_dma_bytes_{executor.vdp_device().dma_bytes()} {}
+
+void Metrics::Recorder::on_frame(std::chrono::nanoseconds host_time) {
+  const auto& statistics = executor_.statistics();
+  const auto dma_bytes = executor_.vdp_device().dma_bytes();
+  add(metrics_.frames_, statistics.frames - previous_.frames);
+  add(metrics_.instructions_, statistics.instructions - previous_.instructions);
+  // the emulated time goes back on a reset, the emulated cycles don't
+  add(metrics_.cycles_,
+      (statistics.cycles + statistics.rewound_cycles) - (previous_.cycles + previous_.rewound_cycles));
+  add(metrics_.idle_cycles_, statistics.idle_cycles - previous_.idle_cycles);
+  add(metrics_.faults_, statistics.faults - previous_.faults);
+  add(metrics_.dma_bytes_, dma_bytes - previous_dma_bytes_);
+  previous_ = statistics;
+  previous_dma_bytes_ = dma_bytes;
+
+  const auto milliseconds = std::chrono::duration<double, std::milli>(host_time).count();
+  const auto bucket = std::ranges::lower_bound(kFrameTimeBuckets, milliseconds) - kFrameTimeBuckets.begin();
+  add(metrics_.frame_time_buckets_[bucket], 1);
+  add(metrics_.frame_time_nanoseconds_, host_time.count());
+  add(metrics_.late_frames_, host_time > kFramePeriod ? 1 : 0);
+}
+
+Metrics::Snapshot Metrics::snapshot() const {
+  Snapshot snapshot{
+      .frames = load(frames_),
+      .instructions = load(instructions_),
+      .cycles = load(cycles_),
+      .idle_cycles = load(idle_cycles_),
+      .late_frames = load(late_frames_),
+      .faults = load(faults_),
+      .dma_bytes = load(dma_bytes_),
+      .frame_time_nanoseconds = load(frame_time_nanoseconds_),
+      .frame_time_buckets = {},
+  };
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    snapshot.frame_time_buckets[i] = load(frame_time_buckets_[i]);
+  }
+  return snapshot;
+}
+
+} // namespace sega
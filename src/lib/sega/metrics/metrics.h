@@ -0,0 +1,63 @@
+#pragma once
+#include "lib/sega/executor/executor.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace sega {
+
+// live numbers of running emulators in lock-free counters, the emulation threads add to them once per frame
+// and `MetricsServer` reads them only when it's scraped
+class Metrics {
+public:
+  // upper bounds of the host frame time histogram buckets in milliseconds, the last bucket is unbounded
+  static constexpr std::array kFrameTimeBuckets = {1.0, 2.0, 4.0, 8.0, 1000.0 / 60, 33.3, 50.0, 100.0};
+  static constexpr size_t kBucketCount = kFrameTimeBuckets.size() + 1;
+
+  struct Snapshot {
+    uint64_t frames;
+    uint64_t instructions;
+    uint64_t cycles;
+    uint64_t idle_cycles;
+    // frames that took longer than 1/60 of a host second
+    uint64_t late_frames;
+    uint64_t faults;
+    uint64_t dma_bytes;
+    uint64_t frame_time_nanoseconds;
+    // not cumulative, a frame is counted only in its own bucket
+    std::array<uint64_t, kBucketCount> frame_time_buckets;
+  };
+
+  // adds the differences of an executor's counters since its previous frame
+  class Recorder {
+  public:
+    Recorder(Metrics& metrics, const Executor& executor);
+
+    // `host_time` is the work on the frame, without the waits of the frame pacing
+    void on_frame(std::chrono::nanoseconds host_time);
+
+  private:
+    Metrics& metrics_;
+    const Executor& executor_;
+    Executor::Statistics previous_;
+    uint64_t previous_dma_bytes_;
+  };
+
+public:
+  Snapshot snapshot() const;
+
+private:
+  std::atomic<uint64_t> frames_{};
+  std::atomic<uint64_t> instructions_{};
+  std::atomic<uint64_t> cycles_{};
+  std::atomic<uint64_t> idle_cycles_{};
+  std::atomic<uint64_t> late_frames_{};
+  std::atomic<uint64_t> faults_{};
+  std::atomic<uint64_t> dma_bytes_{};
+  std::atomic<uint64_t> frame_time_nanoseconds_{};
+  std::array<std::atomic<uint64_t>, kBucketCount> frame_time_buckets_{};
+};
+
+} // namespace sega
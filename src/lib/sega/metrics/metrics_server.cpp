@@ -0,0 +1,229 @@
+#include "metrics_server.h"
+#include "lib/sega/metrics/metrics.h"
+#include "spdlog/spdlog.h"
+#include <arpa/inet.h>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fmt/core.h>
+#include <fstream>
+#include <iterator>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace sega {
+
+namespace {
+
+// the thread checks if it's stopping this often
+constexpr int kPollTimeoutMs = 200;
+
+// a client that doesn't send the request or doesn't read the response is dropped after this
+constexpr int kClientTimeoutMs = 5000;
+
+// the resident set size from procfs, zero if it's unknown
+uint64_t resident_bytes() {
+  std::ifstream file{"/proc/self/statm"};
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  if (!(file >> size >> resident)) {
+    return 0;
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+void append_metric(std::string& out, std::string_view name, std::string_view type, std::string_view help,
+                   auto value) {
+  fmt::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n{} {}\n", name, help, name, type, name, value);
+}
+
+int listen_tcp(uint16_t port) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  const int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int listen_unix(std::string_view path) {
+  sockaddr_un address{};
+  if (path.size() >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.data(), path.size());
+  // a socket file left by a previous run, any other file is the user's and stays
+  struct stat status {};
+  if (lstat(address.sun_path, &status) == 0) {
+    if (!S_ISSOCK(status.st_mode)) {
+      errno = EEXIST;
+      return -1;
+    }
+    unlink(address.sun_path);
+  }
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// waits until the client is ready for `events`, returns false if the server stops or the client stalls
+bool wait_for_client(int client, short events, const std::atomic<bool>& stopping) {
+  for (int waited = 0; !stopping && waited < kClientTimeoutMs; waited += kPollTimeoutMs) {
+    pollfd pending{.fd = client, .events = events, .revents = 0};
+    const int ready = poll(&pending, 1, kPollTimeoutMs);
+    if (ready > 0) {
+      return true;
+    }
+    if (ready < 0 && errno != EINTR) {
+      return false;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(const Metrics& metrics)
+    : metrics_{metrics}, previous_time_{std::chrono::steady_clock::now()}, previous_{metrics.snapshot()} {}
+
+MetricsServer::~MetricsServer() {
+  stopping_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (socket_ >= 0) {
+    close(socket_);
+  }
+  if (!socket_path_.empty()) {
+    unlink(socket_path_.c_str());
+  }
+}
+
+bool MetricsServer::start(std::string_view address) {
+  uint16_t port = 0;
+  const auto [end, error] = std::from_chars(address.data(), address.data() + address.size(), port);
+  const bool is_port = error == std::errc{} && end == address.data() + address.size();
+  socket_ = is_port ? listen_tcp(port) : listen_unix(address);
+  if (socket_ < 0 || listen(socket_, /*backlog=*/4) != 0) {
+    spdlog::error("can't serve metrics on {}: {}", address, std::strerror(errno));
+    return false;
+  }
+  if (!is_port) {
+    socket_path_ = address;
+  }
+  spdlog::info("serving metrics on {}", address);
+  thread_ = std::thread{[this] { serve(); }};
+  return true;
+}
+
+void MetricsServer::serve() {
+  while (!stopping_) {
+    pollfd listening{.fd = socket_, .events = POLLIN, .revents = 0};
+    if (poll(&listening, 1, kPollTimeoutMs) <= 0) {
+      continue;
+    }
+    const int client = accept(socket_, nullptr, nullptr);
+    if (client < 0) {
+      continue;
+    }
+
+    // any request gets the metrics, read it only to let the client finish sending
+    if (!wait_for_client(client, POLLIN, stopping_)) {
+      close(client);
+      continue;
+    }
+    std::array<char, 1024> request;
+    [[maybe_unused]] const auto received = recv(client, request.data(), request.size(), MSG_DONTWAIT);
+
+    const auto body = format();
+    const auto response = fmt::format("HTTP/1.0 200 OK\r\n"
+                                      "Content-Type: text/plain; version=0.0.4\r\n"
+                                      "Content-Length: {}\r\n"
+                                      "Connection: close\r\n\r\n{}",
+                                      body.size(), body);
+    for (size_t sent = 0; sent < response.size();) {
+      if (!wait_for_client(client, POLLOUT, stopping_)) {
+        break;
+      }
+      const auto count = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (count <= 0) {
+        break;
+      }
+      sent += count;
+    }
+    close(client);
+  }
+}
+
+std::string MetricsServer::format() {
+  const auto now = std::chrono::steady_clock::now();
+  const auto current = metrics_.snapshot();
+  const auto seconds = std::chrono::duration<double>(now - previous_time_).count();
+  const auto fps = seconds > 0 ? (current.frames - previous_.frames) / seconds : 0;
+  const auto mips = seconds > 0 ? (current.instructions - previous_.instructions) / seconds / 1e6 : 0;
+  previous_time_ = now;
+  previous_ = current;
+
+  std::string out;
+  append_metric(out, "segacxx_fps", "gauge", "Emulated frames per host second since the previous scrape.", fps);
+  append_metric(out, "segacxx_mips", "gauge", "Millions of instructions per host second since the previous scrape.",
+                mips);
+  append_metric(out, "segacxx_frames_total", "counter", "Emulated frames.", current.frames);
+  append_metric(out, "segacxx_instructions_total", "counter", "Executed instructions.", current.instructions);
+  append_metric(out, "segacxx_cycles_total", "counter", "Emulated 68000 cycles.", current.cycles);
+  append_metric(out, "segacxx_idle_cycles_total", "counter", "Emulated cycles skipped in idle loops.",
+                current.idle_cycles);
+  append_metric(out, "segacxx_late_frames_total", "counter", "Frames that took longer than 1/60 of a host second.",
+                current.late_frames);
+  append_metric(out, "segacxx_faults_total", "counter", "Instructions that faulted, e.g. on a bus error.",
+                current.faults);
+  append_metric(out, "segacxx_dma_bytes_total", "counter", "Bytes written to the video RAMs by DMA.",
+                current.dma_bytes);
+  append_metric(out, "segacxx_resident_memory_bytes", "gauge", "Resident set size of the process.",
+                resident_bytes());
+
+  // the histogram buckets are cumulative
+  constexpr std::string_view kHistogram = "segacxx_frame_time_seconds";
+  fmt::format_to(std::back_inserter(out), "# HELP {} Host time of a frame.\n# TYPE {} histogram\n", kHistogram,
+                 kHistogram);
+  uint64_t count = 0;
+  for (size_t i = 0; i < Metrics::kBucketCount; ++i) {
+    count += current.frame_time_buckets[i];
+    const auto bound =
+        i < Metrics::kFrameTimeBuckets.size() ? fmt::format("{}", Metrics::kFrameTimeBuckets[i] / 1000) : "+Inf";
+    fmt::format_to(std::back_inserter(out), "{}_bucket{{le=\"{}\"}} {}\n", kHistogram, bound, count);
+  }
+  fmt::format_to(std::back_inserter(out), "{}_sum {}\n{}_count {}\n", kHistogram,
+                 current.frame_time_nanoseconds / 1e9, kHistogram, count);
+  return out;
+}
+
+} // namespace sega
@@ -0,0 +1,42 @@
+#pragma once
+#include "lib/sega/metrics/metrics.h"
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace sega {
+
+// serves the metrics in the Prometheus text format over HTTP, on a loopback TCP port or a Unix domain socket;
+// the thread waits for connections, so the emulator pays nothing when nobody scrapes
+class MetricsServer {
+public:
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer(MetricsServer&&) = delete;
+
+  MetricsServer(const Metrics& metrics);
+  ~MetricsServer();
+
+  // `address` is a port number on 127.0.0.1 or a socket path, returns false if it can't listen
+  bool start(std::string_view address);
+
+private:
+  void serve();
+  std::string format();
+
+private:
+  const Metrics& metrics_;
+  int socket_{-1};
+  // removed when the server stops, empty for a TCP port
+  std::string socket_path_;
+  std::atomic<bool> stopping_{};
+  std::thread thread_;
+
+  // FPS and MIPS are averaged between scrapes
+  std::chrono::steady_clock::time_point previous_time_;
+  Metrics::Snapshot previous_{};
+};
+
+} // namespace sega
@@ -0,0 +1,149 @@
+#include "perf_counters.h"
+#include "magic_enum/magic_enum.hpp"
+#include "spdlog/spdlog.h"
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace sega {
+
+namespace {
+
+// the header of the group read
+constexpr size_t kTimeEnabled = 1;
+constexpr size_t kTimeRunning = 2;
+constexpr size_t kValues = 3;
+
+#ifdef __linux__
+
+struct EventConfig {
+  uint32_t type;
+  uint64_t config;
+};
+
+constexpr uint64_t cache_miss(uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+constexpr std::array<EventConfig, kPerfEvents> kEventConfigs = {{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_LL)},
+}};
+
+int open_event(const EventConfig& event, int group_fd) {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // the emulator's own work, this also works with `perf_event_paranoid` = 2
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, group_fd, /*flags=*/0));
+}
+
+#endif
+
+} // namespace
+
+uint64_t PerfReport::count(PerfPhase phase, PerfEvent event) const {
+  return counts[std::to_underlying(phase)][std::to_underlying(event)];
+}
+
+PerfCounters::PerfCounters() {
+  fds_.fill(-1);
+#ifdef __linux__
+  for (size_t i = 0; i < kPerfEvents; ++i) {
+    fds_[i] = open_event(kEventConfigs[i], leader_);
+    if (fds_[i] < 0) {
+      spdlog::warn("can't open the {} counter: {}", magic_enum::enum_name(static_cast<PerfEvent>(i)),
+                   std::strerror(errno));
+      continue;
+    }
+    if (leader_ < 0) {
+      leader_ = fds_[i];
+    }
+    report_.supported[i] = true;
+    ++opened_;
+  }
+#else
+  spdlog::warn("hardware counters are not supported on this platform");
+#endif
+  report_.available = opened_ > 0;
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (const auto fd : fds_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+#endif
+}
+
+void PerfCounters::enter(PerfPhase phase) {
+  account();
+  measuring_ = true;
+  phase_ = phase;
+}
+
+void PerfCounters::leave() {
+  account();
+  measuring_ = false;
+}
+
+const PerfReport& PerfCounters::report() const {
+  return report_;
+}
+
+void PerfCounters::account() {
+  Group group;
+  if (!read(group)) {
+    return;
+  }
+  if (measuring_) {
+    const auto enabled = group[kTimeEnabled] - last_[kTimeEnabled];
+    const auto running = group[kTimeRunning] - last_[kTimeRunning];
+    auto& counts = report_.counts[std::to_underlying(phase_)];
+    size_t value = kValues;
+    for (size_t i = 0; i < kPerfEvents; ++i) {
+      if (!report_.supported[i]) {
+        continue;
+      }
+      auto delta = group[value] - last_[value];
+      // the counters are multiplexed if there are not enough of them, the counts are scaled then
+      if (running > 0 && running < enabled) {
+        delta = static_cast<uint64_t>(static_cast<double>(delta) * enabled / running);
+      }
+      counts[i] += delta;
+      ++value;
+    }
+  }
+  last_ = group;
+}
+
+bool PerfCounters::read(Group& group) const {
+#ifdef __linux__
+  if (leader_ < 0) {
+    return false;
+  }
+  const auto size = (kValues + opened_) * sizeof(uint64_t);
+  return ::read(leader_, group.data(), size) == static_cast<ssize_t>(size);
+#else
+  return false;
+#endif
+}
+
+} // namespace sega
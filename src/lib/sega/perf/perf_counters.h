@@ -0,0 +1,71 @@
+#pragma once
+#include "magic_enum/magic_enum.hpp"
+#include <array>
+#include <cstdint>
+
+namespace sega {
+
+enum class PerfEvent {
+  Cycles,
+  Instructions,
+  BranchMisses,
+  L1dMisses,
+  LlcMisses,
+};
+
+// the parts of a frame measured separately
+enum class PerfPhase {
+  Cpu,
+  Vdp,
+  Present,
+};
+
+inline constexpr size_t kPerfEvents = magic_enum::enum_count<PerfEvent>();
+inline constexpr size_t kPerfPhases = magic_enum::enum_count<PerfPhase>();
+
+struct PerfReport {
+  // false if no counter can be opened, e.g. not on Linux or with a restrictive `perf_event_paranoid`
+  bool available;
+  // some events may be missing, e.g. the cache events in virtual machines
+  std::array<bool, kPerfEvents> supported;
+  // user-space counts of the measuring thread by the phase
+  std::array<std::array<uint64_t, kPerfEvents>, kPerfPhases> counts;
+
+  uint64_t count(PerfPhase phase, PerfEvent event) const;
+};
+
+// hardware counters of the creating thread, read only on phase changes, so a phase should last at least a scanline;
+// all counts stay zero if the counters are unavailable
+class PerfCounters {
+public:
+  PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  ~PerfCounters();
+
+  // the counts since the previous call go to the previous phase
+  void enter(PerfPhase phase);
+  // the counts since the previous call go to the previous phase, nothing is counted until the next `enter`
+  void leave();
+
+  const PerfReport& report() const;
+
+private:
+  // the group read: the number of counters, the enabled and running times, the values in the opening order
+  using Group = std::array<uint64_t, 3 + kPerfEvents>;
+
+  void account();
+  bool read(Group& group) const;
+
+private:
+  // the opened counter of each event, the first one is the group leader
+  std::array<int, kPerfEvents> fds_;
+  int leader_{-1};
+  size_t opened_{};
+
+  PerfReport report_{};
+  Group last_{};
+  bool measuring_{};
+  PerfPhase phase_{};
+};
+
+} // namespace sega
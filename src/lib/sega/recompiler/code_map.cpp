@@ -0,0 +1,34 @@
+#include "code_map.h"
+#include "lib/common/memory/types.h"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace sega {
+
+CodeMap::CodeMap(std::vector<Kind> kinds) : kinds_{std::move(kinds)} {
+  for (size_t i = 0; i < kinds_.size(); ++i) {
+    const AddressType address = i * 2;
+    ++counts_[static_cast<size_t>(kinds_[i])];
+    if (regions_.empty() || regions_.back().kind != kinds_[i]) {
+      regions_.push_back({.begin = address, .end = address + 2, .kind = kinds_[i]});
+    } else {
+      regions_.back().end = address + 2;
+    }
+  }
+}
+
+CodeMap::Kind CodeMap::kind(AddressType address) const {
+  const size_t index = address / 2;
+  return index < kinds_.size() ? kinds_[index] : Kind::Data;
+}
+
+size_t CodeMap::count(Kind kind) const {
+  return counts_[static_cast<size_t>(kind)];
+}
+
+const std::vector<CodeMap::Region>& CodeMap::regions() const {
+  return regions_;
+}
+
+} // namespace sega
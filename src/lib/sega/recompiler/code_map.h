@@ -0,0 +1,41 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sega {
+
+// what each word of the ROM is, as found by the code walker
+class CodeMap {
+public:
+  enum class Kind : uint8_t {
+    Data,
+    Code,
+    JumpTable,
+  };
+
+  struct Region {
+    AddressType begin;
+    AddressType end;
+    Kind kind;
+  };
+
+public:
+  CodeMap() = default;
+  CodeMap(std::vector<Kind> kinds);
+
+  Kind kind(AddressType address) const;
+  size_t count(Kind kind) const;
+
+  // consecutive words of the same kind
+  const std::vector<Region>& regions() const;
+
+private:
+  std::vector<Kind> kinds_;
+  std::vector<Region> regions_;
+  std::array<size_t, 3> counts_{};
+};
+
+} // namespace sega
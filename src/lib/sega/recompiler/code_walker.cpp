@@ -0,0 +1,381 @@
+#include "code_walker.h"
+#include "lib/common/memory/types.h"
+#include "lib/common/util/thread_pool.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/registers/registers.h"
+#include "lib/m68k/target/target.h"
+#include "lib/sega/recompiler/code_map.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace sega {
+
+namespace {
+
+// the longest instruction is 10 bytes
+constexpr AddressType kMaxInstructionSize = 10;
+
+// jump tables are scanned until an invalid entry, but not further than this
+constexpr size_t kMaxJumpTableEntries = 256;
+
+// all branches have the displacement relative to the address after the opcode word
+AddressType branch_target(AddressType pc, const m68k::Instruction& instruction) {
+  const auto data = instruction.data();
+  if (instruction.size() == m68k::Instruction::ByteSize) {
+    return pc + 2 + static_cast<SignedByte>(data);
+  }
+  return pc + 2 + static_cast<SignedWord>(data);
+}
+
+// the address of a target that doesn't depend on registers, for indexed targets it's the base address
+std::optional<AddressType> static_address(const m68k::Target& target, AddressType next_pc, Device& device) {
+  using enum m68k::Target::Kind;
+  switch (target.kind()) {
+  case AbsoluteShortKind:
+  case AbsoluteLongKind:
+  case ProgramCounterDisplacementKind:
+  case ProgramCounterIndexKind: {
+    // index registers are zero
+    m68k::Registers registers;
+    std::memset(&registers, 0, sizeof(registers));
+    registers.pc = next_pc;
+    return target.effective_address({.registers = registers, .device = device});
+  }
+  default:
+    return std::nullopt;
+  }
+}
+
+bool is_unconditional_jump(const m68k::Instruction& instruction) {
+  using enum m68k::Instruction::Kind;
+  return (instruction.kind() == BccKind && instruction.condition() == m68k::Instruction::TrueCond) ||
+         instruction.kind() == JmpKind;
+}
+
+} // namespace
+
+bool ends_basic_block(const m68k::Instruction& instruction) {
+  using enum m68k::Instruction::Kind;
+  switch (instruction.kind()) {
+  case BccKind:
+  case BsrKind:
+  case ChkKind:
+  case DbccKind:
+  case DivsKind:
+  case DivuKind:
+  case JmpKind:
+  case JsrKind:
+  case MoveToSrKind:
+  case AndiToSrKind:
+  case EoriToSrKind:
+  case OriToSrKind:
+  case ResetKind:
+  case RteKind:
+  case RtrKind:
+  case RtsKind:
+  case TrapKind:
+  case TrapvKind:
+    return true;
+  default:
+    return false;
+  }
+}
+
+CodeWalker::AtomicBitmap::AtomicBitmap(size_t size) : words_((size + 63) / 64) {}
+
+bool CodeWalker::AtomicBitmap::test_and_set(size_t index) {
+  const uint64_t mask = uint64_t{1} << (index % 64);
+  return words_[index / 64].fetch_or(mask, std::memory_order_relaxed) & mask;
+}
+
+bool CodeWalker::AtomicBitmap::test(size_t index) const {
+  const uint64_t mask = uint64_t{1} << (index % 64);
+  return words_[index / 64].load(std::memory_order_relaxed) & mask;
+}
+
+CodeWalker::CodeWalker(DataView rom, ThreadPool& pool)
+    : rom_{rom}, rom_device_{rom}, pool_{pool}, leaders_{rom.size() / 2}, visited_{rom.size() / 2},
+      code_{rom.size() / 2}, jump_tables_{rom.size() / 2} {}
+
+void CodeWalker::add_entry_point(AddressType pc) {
+  if (is_valid_pc(pc)) {
+    leaders_.test_and_set(pc / 2);
+  }
+}
+
+void CodeWalker::add_vector_table_entry_points() {
+  // skip the initial stack pointer and vectors pointing into the ROM header (usually zeros)
+  constexpr size_t kVectorCount = 64;
+  constexpr AddressType kHeaderSize = 0x200;
+  for (size_t vector = 1; vector < kVectorCount; ++vector) {
+    if (const auto pc = read_vector(vector); pc && *pc >= kHeaderSize) {
+      add_entry_point(*pc);
+    }
+  }
+}
+
+void CodeWalker::walk() {
+  std::vector<AddressType> entry_points;
+  for (size_t index = 0; index < rom_.size() / 2; ++index) {
+    if (leaders_.test(index)) {
+      entry_points.push_back(index * 2);
+    }
+  }
+
+  TaskGroup group{pool_};
+  group_ = &group;
+  for (const auto pc : entry_points) {
+    group.run([this, pc] { walk_from(pc); });
+  }
+  group.wait();
+
+  // an offset table ends where the code begins and its `MOVE` may be decoded by another task,
+  // so the tables are resolved between the walks; while the walk is in progress the result would depend on
+  // the order of its tasks
+  while (true) {
+    std::vector<DecodedInstruction> jump_tables;
+    {
+      std::lock_guard lock{jump_tables_mutex_};
+      jump_tables.swap(pending_jump_tables_);
+    }
+    if (jump_tables.empty()) {
+      break;
+    }
+    std::ranges::sort(jump_tables, {}, &DecodedInstruction::pc);
+    std::ranges::sort(instructions_, {}, &DecodedInstruction::pc);
+    std::vector<AddressType> targets;
+    for (const auto& jump : jump_tables) {
+      add_jump_table(jump, targets);
+    }
+    for (const auto target : targets) {
+      add_leader(target);
+    }
+    group.wait();
+  }
+  group_ = nullptr;
+
+  std::ranges::sort(instructions_, {}, &DecodedInstruction::pc);
+}
+
+const std::vector<CodeWalker::DecodedInstruction>& CodeWalker::instructions() const {
+  return instructions_;
+}
+
+std::vector<CodeWalker::BasicBlock> CodeWalker::basic_blocks() const {
+  const auto find = [this](AddressType pc) -> const DecodedInstruction* {
+    const auto it = std::ranges::lower_bound(instructions_, pc, {}, &DecodedInstruction::pc);
+    return it != instructions_.end() && it->pc == pc ? &*it : nullptr;
+  };
+
+  std::vector<BasicBlock> blocks;
+  for (size_t index = 0; index < rom_.size() / 2; ++index) {
+    if (!leaders_.test(index)) {
+      continue;
+    }
+    BasicBlock block{.begin = static_cast<AddressType>(index * 2)};
+    for (const auto* decoded = find(block.begin); decoded; decoded = find(decoded->next_pc)) {
+      block.instructions.push_back(*decoded);
+      if (ends_basic_block(decoded->instruction) || leaders_.test(decoded->next_pc / 2)) {
+        break;
+      }
+    }
+    if (!block.instructions.empty()) {
+      blocks.emplace_back(std::move(block));
+    }
+  }
+  return blocks;
+}
+
+CodeMap CodeWalker::code_map() const {
+  std::vector<CodeMap::Kind> kinds(rom_.size() / 2, CodeMap::Kind::Data);
+  for (size_t index = 0; index < kinds.size(); ++index) {
+    if (code_.test(index)) {
+      kinds[index] = CodeMap::Kind::Code;
+    } else if (jump_tables_.test(index)) {
+      kinds[index] = CodeMap::Kind::JumpTable;
+    }
+  }
+  return CodeMap{std::move(kinds)};
+}
+
+void CodeWalker::walk_from(AddressType pc) {
+  // decode the linear sequence until a block end or an already visited instruction
+  std::vector<DecodedInstruction> decoded_instructions;
+  while (is_valid_pc(pc) && !visited_.test_and_set(pc / 2)) {
+    const auto decoded = decode(pc);
+    if (!decoded) {
+      break;
+    }
+    for (AddressType address = decoded->pc; address < decoded->next_pc; address += 2) {
+      code_.test_and_set(address / 2);
+    }
+    decoded_instructions.push_back(*decoded);
+    add_successors(*decoded);
+    if (ends_basic_block(decoded->instruction)) {
+      break;
+    }
+    pc = decoded->next_pc;
+  }
+
+  std::lock_guard lock{instructions_mutex_};
+  instructions_.insert(instructions_.end(), decoded_instructions.begin(), decoded_instructions.end());
+}
+
+void CodeWalker::add_leader(AddressType pc) {
+  if (is_valid_pc(pc) && !leaders_.test_and_set(pc / 2)) {
+    group_->run([this, pc] { walk_from(pc); });
+  }
+}
+
+void CodeWalker::add_successors(const DecodedInstruction& decoded) {
+  using enum m68k::Instruction::Kind;
+  const auto& instruction = decoded.instruction;
+
+  switch (instruction.kind()) {
+  case BccKind:
+    add_leader(branch_target(decoded.pc, instruction));
+    if (instruction.condition() != m68k::Instruction::TrueCond) {
+      add_leader(decoded.next_pc);
+    }
+    break;
+  case BsrKind:
+  case DbccKind:
+    add_leader(branch_target(decoded.pc, instruction));
+    add_leader(decoded.next_pc);
+    break;
+  case JmpKind:
+  case JsrKind:
+    if (instruction.dst().kind() == m68k::Target::ProgramCounterIndexKind) {
+      std::lock_guard lock{jump_tables_mutex_};
+      pending_jump_tables_.push_back(decoded);
+    } else if (const auto target = static_address(instruction.dst(), decoded.next_pc, rom_device_)) {
+      add_leader(*target);
+    }
+    if (instruction.kind() == JsrKind) {
+      add_leader(decoded.next_pc);
+    }
+    break;
+  case TrapKind:
+    if (const auto handler = read_vector(instruction.data())) {
+      add_leader(*handler);
+    }
+    add_leader(decoded.next_pc);
+    break;
+  case RteKind:
+  case RtrKind:
+  case RtsKind:
+    break;
+  default:
+    if (ends_basic_block(instruction)) {
+      add_leader(decoded.next_pc);
+    }
+    break;
+  }
+}
+
+void CodeWalker::add_jump_table(const DecodedInstruction& decoded, std::vector<AddressType>& targets) {
+  const auto base = static_address(decoded.instruction.dst(), decoded.next_pc, rom_device_);
+  if (!base) {
+    return;
+  }
+
+  // offset table: `MOVE.W table(PC, Dn.W), Dn` followed by `JMP base(PC, Dn.W)`
+  const auto* prev = find_previous(decoded.pc);
+  const bool has_offset_table = prev && prev->instruction.kind() == m68k::Instruction::MoveKind &&
+                                prev->instruction.size() == m68k::Instruction::WordSize &&
+                                prev->instruction.src().kind() == m68k::Target::ProgramCounterIndexKind;
+  if (has_offset_table) {
+    const auto table = static_address(prev->instruction.src(), prev->next_pc, rom_device_);
+    for (size_t i = 0; table && i < kMaxJumpTableEntries; ++i) {
+      const AddressType entry = *table + i * 2;
+      const auto offset = read_word(entry);
+      // the table usually ends where the code begins
+      if (!offset || code_.test(entry / 2)) {
+        break;
+      }
+      const AddressType target = *base + static_cast<SignedWord>(*offset);
+      if (!is_valid_pc(target)) {
+        break;
+      }
+      jump_tables_.test_and_set(entry / 2);
+      targets.push_back(target);
+    }
+    return;
+  }
+
+  // branch table: `JMP base(PC, Dn.W)` followed by same-sized `BRA` or `JMP` instructions
+  const auto first = decode(*base);
+  if (!first || !is_unconditional_jump(first->instruction)) {
+    return;
+  }
+  const AddressType stride = first->next_pc - first->pc;
+  for (size_t i = 0; i < kMaxJumpTableEntries; ++i) {
+    const AddressType entry = *base + i * stride;
+    const auto branch = decode(entry);
+    if (!branch || !is_unconditional_jump(branch->instruction) || branch->next_pc - branch->pc != stride) {
+      break;
+    }
+    targets.push_back(entry);
+  }
+}
+
+const CodeWalker::DecodedInstruction* CodeWalker::find_previous(AddressType pc) const {
+  // the instructions starting at different addresses may overlap, the lowest one is taken
+  const auto begin = pc >= kMaxInstructionSize ? pc - kMaxInstructionSize : 0;
+  for (auto it = std::ranges::lower_bound(instructions_, begin, {}, &DecodedInstruction::pc);
+       it != instructions_.end() && it->pc < pc; ++it) {
+    if (it->next_pc == pc) {
+      return &*it;
+    }
+  }
+  return nullptr;
+}
+
+std::optional<CodeWalker::DecodedInstruction> CodeWalker::decode(AddressType pc) {
+  if (!is_valid_pc(pc) || pc + kMaxInstructionSize > rom_.size()) {
+    return std::nullopt;
+  }
+
+  m68k::Registers registers;
+  std::memset(&registers, 0, sizeof(registers));
+  registers.pc = pc;
+  auto instruction = m68k::Instruction::decode({.registers = registers, .device = rom_device_});
+  if (!instruction) {
+    spdlog::debug("stop walking at pc: {:06x} what: {}", pc, instruction.error().what());
+    return std::nullopt;
+  }
+  return DecodedInstruction{.pc = pc, .next_pc = registers.pc, .instruction = *instruction};
+}
+
+std::optional<Word> CodeWalker::read_word(AddressType address) {
+  if (address + sizeof(Word) > rom_.size()) {
+    return std::nullopt;
+  }
+  const auto word = static_cast<Device&>(rom_device_).read<Word>(address);
+  return word ? std::optional{*word} : std::nullopt;
+}
+
+std::optional<AddressType> CodeWalker::read_vector(size_t vector) {
+  if ((vector + 1) * sizeof(Long) > rom_.size()) {
+    return std::nullopt;
+  }
+  const auto address = static_cast<Device&>(rom_device_).read<Long>(vector * sizeof(Long));
+  if (!address || !is_valid_pc(*address)) {
+    return std::nullopt;
+  }
+  return *address;
+}
+
+bool CodeWalker::is_valid_pc(AddressType pc) const {
+  return (pc & 1) == 0 && pc < rom_.size();
+}
+
+} // namespace sega
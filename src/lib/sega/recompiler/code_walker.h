@@ -0,0 +1,92 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include "lib/common/util/thread_pool.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/sega/memory/rom_device.h"
+#include "lib/sega/recompiler/code_map.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace sega {
+
+// finds reachable code in the ROM by the recursive descent from the entry points, in parallel;
+// indirect jumps (e.g. `JMP (A0)` or `RTS`) are not followed, except for recognized jump tables
+class CodeWalker {
+public:
+  struct DecodedInstruction {
+    AddressType pc;
+    AddressType next_pc;
+    m68k::Instruction instruction;
+  };
+
+  struct BasicBlock {
+    AddressType begin;
+    std::vector<DecodedInstruction> instructions;
+  };
+
+public:
+  CodeWalker(DataView rom, ThreadPool& pool);
+
+  void add_entry_point(AddressType pc);
+  // all exception vectors pointing into the ROM
+  void add_vector_table_entry_points();
+  void walk();
+
+  // sorted by the address
+  const std::vector<DecodedInstruction>& instructions() const;
+  std::vector<BasicBlock> basic_blocks() const;
+  CodeMap code_map() const;
+
+private:
+  class AtomicBitmap {
+  public:
+    AtomicBitmap(size_t size);
+    // returns the previous value
+    bool test_and_set(size_t index);
+    bool test(size_t index) const;
+
+  private:
+    std::vector<std::atomic<uint64_t>> words_;
+  };
+
+  void walk_from(AddressType pc);
+  void add_leader(AddressType pc);
+  void add_successors(const DecodedInstruction& decoded);
+  // appends the jump table targets, called after the walk since an offset table is bounded by the found code
+  void add_jump_table(const DecodedInstruction& decoded, std::vector<AddressType>& targets);
+  // the found instruction ending at `pc`, `instructions_` must be sorted
+  const DecodedInstruction* find_previous(AddressType pc) const;
+
+  std::optional<DecodedInstruction> decode(AddressType pc);
+  std::optional<Word> read_word(AddressType address);
+  std::optional<AddressType> read_vector(size_t vector);
+  bool is_valid_pc(AddressType pc) const;
+
+private:
+  DataView rom_;
+  RomDevice rom_device_;
+  ThreadPool& pool_;
+  TaskGroup* group_{};
+
+  // one bit per word of the ROM
+  AtomicBitmap leaders_;
+  AtomicBitmap visited_;
+  AtomicBitmap code_;
+  AtomicBitmap jump_tables_;
+
+  std::mutex instructions_mutex_;
+  std::vector<DecodedInstruction> instructions_;
+
+  // `JMP table(PC, Dn.W)` instructions found by the walk
+  std::mutex jump_tables_mutex_;
+  std::vector<DecodedInstruction> pending_jump_tables_;
+};
+
+// whether the instruction may change the program counter not just to the next instruction
+bool ends_basic_block(const m68k::Instruction& instruction);
+
+} // namespace sega
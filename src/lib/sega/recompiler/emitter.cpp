@@ -0,0 +1,881 @@
+#include "emitter.h"
+#include "lib/common/memory/types.h"
+#include "lib/m68k/instruction/instruction.h"
+#include "lib/m68k/target/target.h"
+#include "lib/sega/recompiler/code_walker.h"
+#include "magic_enum/magic_enum.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fmt/core.h>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sega {
+
+namespace {
+
+using m68k::Instruction;
+using m68k::Target;
+
+// decoded instructions may have uninitialized fields, so the value can be out of the enum
+template<typename Enum>
+std::string enum_literal(std::string_view scope, std::string_view type, Enum value) {
+  if (const auto name = magic_enum::enum_name(value); !name.empty()) {
+    return fmt::format("{}::{}", scope, name);
+  }
+  return fmt::format("static_cast<{}::{}>({})", scope, type, static_cast<int>(value));
+}
+
+std::string emit_target(const Target& target) {
+  return fmt::format("Target{{}}.kind({}).size({}).index({}).ext_word0({:#x}).ext_word1({:#x}).address({:#x})",
+                     enum_literal("Target", "Kind", target.kind()), target.size(), target.index(), target.ext_word0(),
+                     target.ext_word1(), target.address());
+}
+
+std::string emit_instruction(const Instruction& instruction) {
+  auto result = fmt::format("Instruction{{}}.kind({}).size({}).condition({}).data({:#x})",
+                            enum_literal("Instruction", "Kind", instruction.kind()),
+                            enum_literal("Instruction", "Size", instruction.size()),
+                            enum_literal("Instruction", "Condition", instruction.condition()), instruction.data());
+  if (instruction.has_src()) {
+    result += fmt::format(".src({})", emit_target(instruction.src()));
+  }
+  if (instruction.has_dst()) {
+    result += fmt::format(".dst({})", emit_target(instruction.dst()));
+  }
+  return result;
+}
+
+std::string block_name(AddressType pc) {
+  return fmt::format("block_{:06x}", pc);
+}
+
+// the generated code sees D0 - D7 as `regs.da[0]` - `regs.da[7]` and A0 - A7 as `regs.da[8]` - `regs.da[15]`
+std::string data_register(uint8_t index) {
+  return fmt::format("regs.da[{}]", index);
+}
+
+std::string address_register(uint8_t index) {
+  return fmt::format("regs.da[{}]", 8 + index);
+}
+
+bool is_valid_size(Instruction::Size size) {
+  return size == Instruction::ByteSize || size == Instruction::WordSize || size == Instruction::LongSize;
+}
+
+uint32_t bit_count(Instruction::Size size) {
+  return size * 8;
+}
+
+uint64_t size_mask(Instruction::Size size) {
+  return (uint64_t{1} << bit_count(size)) - 1;
+}
+
+std::string_view type_name(Instruction::Size size) {
+  switch (size) {
+  case Instruction::ByteSize:
+    return "Byte";
+  case Instruction::WordSize:
+    return "Word";
+  default:
+    return "Long";
+  }
+}
+
+// `value + offset` with the constant folded into an addition or a subtraction
+std::string add_offset(std::string_view value, int64_t offset) {
+  if (offset == 0) {
+    return std::string{value};
+  }
+  return offset > 0 ? fmt::format("{} + {:#x}", value, offset) : fmt::format("{} - {:#x}", value, -offset);
+}
+
+// the flags are computed as `execute` computes them on zero-extended 64-bit values
+std::string msb(std::string_view value, Instruction::Size size) {
+  return fmt::format("(({} >> {}) & 1)", value, bit_count(size) - 1);
+}
+
+std::string negative(std::string_view value, Instruction::Size size) {
+  return fmt::format("{} != 0", msb(value, size));
+}
+
+std::string zero(std::string_view value, Instruction::Size size) {
+  return fmt::format("({} & {:#x}) == 0", value, size_mask(size));
+}
+
+std::string carry(std::string_view value, Instruction::Size size) {
+  return fmt::format("({} >> {}) != 0", value, bit_count(size));
+}
+
+std::string overflow(std::string_view lhs, std::string_view rhs, std::string_view result, Instruction::Size size,
+                     bool subtract) {
+  const auto lhs_msb = subtract ? fmt::format("({} ^ 1)", msb(lhs, size)) : msb(lhs, size);
+  return fmt::format("{} == {} && {} != {}", lhs_msb, msb(rhs, size), msb(result, size), lhs_msb);
+}
+
+std::optional<std::string> condition(Instruction::Condition cond) {
+  switch (cond) {
+  case Instruction::TrueCond:
+    return "true";
+  case Instruction::FalseCond:
+    return "false";
+  case Instruction::HigherCond:
+    return "!regs.sr.carry && !regs.sr.zero";
+  case Instruction::LowerOrSameCond:
+    return "regs.sr.carry || regs.sr.zero";
+  case Instruction::CarryClearCond:
+    return "!regs.sr.carry";
+  case Instruction::CarrySetCond:
+    return "regs.sr.carry";
+  case Instruction::NotEqualCond:
+    return "!regs.sr.zero";
+  case Instruction::EqualCond:
+    return "regs.sr.zero";
+  case Instruction::OverflowClearCond:
+    return "!regs.sr.overflow";
+  case Instruction::OverflowSetCond:
+    return "regs.sr.overflow";
+  case Instruction::PlusCond:
+    return "!regs.sr.negative";
+  case Instruction::MinusCond:
+    return "regs.sr.negative";
+  case Instruction::GreaterOrEqualCond:
+    return "regs.sr.negative == regs.sr.overflow";
+  case Instruction::LessThanCond:
+    return "regs.sr.negative != regs.sr.overflow";
+  case Instruction::GreaterThanCond:
+    return "!regs.sr.zero && regs.sr.negative == regs.sr.overflow";
+  case Instruction::LessOrEqualCond:
+    return "regs.sr.zero || regs.sr.negative != regs.sr.overflow";
+  default:
+    return std::nullopt;
+  }
+}
+
+// the program counter after a branch taken at `pc`, as `execute` displaces it; nullopt if it's odd
+std::optional<AddressType> displace(AddressType pc, const Instruction& instruction, bool ignore_parsed_word_always) {
+  if (instruction.size() == Instruction::ByteSize) {
+    pc += static_cast<SignedByte>(instruction.data());
+  } else {
+    const auto offset = static_cast<SignedWord>(instruction.data());
+    pc += offset;
+    if (offset < 0 || ignore_parsed_word_always) {
+      pc -= 2;
+    }
+  }
+  if (pc & 1) {
+    return std::nullopt;
+  }
+  return pc;
+}
+
+// emits the code of one instruction working directly on the registers and the bus: the operands, the effective
+// addresses and the flags are resolved here, the code does what `Instruction::execute` would do with them
+class InstructionEmitter {
+public:
+  InstructionEmitter(const CodeWalker::DecodedInstruction& decoded, DataView rom)
+      : inst_{decoded.instruction}, next_pc_{decoded.next_pc}, rom_{rom} {}
+
+  // returns nullopt if the instruction kind or an operand isn't specialized, it's left to the interpreter then
+  std::optional<std::string> emit() {
+    if (!emit_kind()) {
+      return std::nullopt;
+    }
+    return std::move(code_);
+  }
+
+private:
+  // an operand is pre-decremented on the first access and post-incremented once, as `Target` does it
+  struct Operand {
+    Target target;
+    bool decremented{};
+    bool incremented{};
+  };
+
+  template<typename... Args>
+  void line(fmt::format_string<Args...> format, Args&&... args) {
+    code_ += "    ";
+    code_ += fmt::format(format, std::forward<Args>(args)...);
+    code_ += "\n";
+  }
+
+  bool emit_kind() {
+    switch (inst_.kind()) {
+    case Instruction::MoveKind:
+      return emit_move();
+    case Instruction::MoveaKind:
+      return emit_movea();
+    case Instruction::MoveqKind:
+      return emit_moveq();
+    case Instruction::AddKind:
+    case Instruction::AddiKind:
+    case Instruction::AndKind:
+    case Instruction::AndiKind:
+    case Instruction::CmpKind:
+    case Instruction::CmpiKind:
+    case Instruction::CmpmKind:
+    case Instruction::EorKind:
+    case Instruction::EoriKind:
+    case Instruction::OrKind:
+    case Instruction::OriKind:
+    case Instruction::SubKind:
+    case Instruction::SubiKind:
+      return emit_binary();
+    case Instruction::AddaKind:
+    case Instruction::CmpaKind:
+    case Instruction::SubaKind:
+      return emit_address_arithmetic();
+    case Instruction::AddqKind:
+    case Instruction::SubqKind:
+      return emit_quick();
+    case Instruction::ClrKind:
+    case Instruction::NegKind:
+    case Instruction::NotKind:
+      return emit_unary();
+    case Instruction::TstKind:
+      return emit_tst();
+    case Instruction::SwapKind:
+      return emit_swap();
+    case Instruction::ExtKind:
+      return emit_ext();
+    case Instruction::LeaKind:
+      return emit_lea();
+    case Instruction::BccKind:
+      return emit_bcc();
+    case Instruction::DbccKind:
+      return emit_dbcc();
+    case Instruction::BsrKind:
+      return emit_bsr();
+    case Instruction::JmpKind:
+    case Instruction::JsrKind:
+      return emit_jump();
+    case Instruction::RtsKind:
+      return emit_rts();
+    case Instruction::NopKind:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  bool emit_move() {
+    if (!is_valid_size(inst_.size())) {
+      return false;
+    }
+    Operand src{inst_.src()};
+    Operand dst{inst_.dst()};
+
+    // the source is read with the program counter after its extension words, it isn't restored on an error
+    on_error_ = fmt::format("regs.pc = {:#08x}; ", inst_.data());
+    const bool read = emit_read(src, inst_.size(), "src", inst_.data());
+    on_error_.clear();
+    if (!read) {
+      return false;
+    }
+    emit_postincrement(src);
+    if (!emit_write(dst, inst_.size(), "src")) {
+      return false;
+    }
+    emit_logic_flags("src", inst_.size());
+    emit_postincrement(dst);
+    return true;
+  }
+
+  bool emit_movea() {
+    if (inst_.size() != Instruction::WordSize && inst_.size() != Instruction::LongSize) {
+      return false;
+    }
+    Operand src{inst_.src()};
+    Operand dst{inst_.dst()};
+
+    on_error_ = fmt::format("regs.pc = {:#08x}; ", inst_.data());
+    const bool read = emit_read_extended(src, "src", inst_.data());
+    on_error_.clear();
+    if (!read) {
+      return false;
+    }
+    emit_postincrement(src);
+    if (!emit_write(dst, Instruction::LongSize, "src")) {
+      return false;
+    }
+    emit_postincrement(dst);
+    return true;
+  }
+
+  bool emit_moveq() {
+    Operand dst{inst_.dst()};
+    const auto value = static_cast<Long>(static_cast<SignedByte>(inst_.data()));
+    if (!emit_write(dst, Instruction::LongSize, fmt::format("{:#x}", value))) {
+      return false;
+    }
+    line("regs.sr.negative = {};", (value >> 31) != 0);
+    line("regs.sr.zero = {};", value == 0);
+    line("regs.sr.overflow = false;");
+    line("regs.sr.carry = false;");
+    return true;
+  }
+
+  bool emit_binary() {
+    if (!is_valid_size(inst_.size())) {
+      return false;
+    }
+    Operand src{inst_.src()};
+    Operand dst{inst_.dst()};
+
+    std::string_view operation;
+    bool arithmetic = true;
+    bool subtract = false;
+    bool compare = false;
+    switch (inst_.kind()) {
+    case Instruction::AddKind:
+    case Instruction::AddiKind:
+      operation = "src + dst";
+      break;
+    case Instruction::SubKind:
+    case Instruction::SubiKind:
+      operation = "dst - src";
+      subtract = true;
+      break;
+    case Instruction::CmpKind:
+    case Instruction::CmpiKind:
+    case Instruction::CmpmKind:
+      operation = "dst - src";
+      subtract = true;
+      compare = true;
+      break;
+    case Instruction::AndKind:
+    case Instruction::AndiKind:
+      operation = "src & dst";
+      arithmetic = false;
+      break;
+    case Instruction::EorKind:
+    case Instruction::EoriKind:
+      operation = "src ^ dst";
+      arithmetic = false;
+      break;
+    default:
+      operation = "src | dst";
+      arithmetic = false;
+      break;
+    }
+
+    if (!emit_read(src, inst_.size(), "src", next_pc_)) {
+      return false;
+    }
+    emit_postincrement(src);
+    if (!emit_read(dst, inst_.size(), "dst", next_pc_)) {
+      return false;
+    }
+    line("const LongLong result = {};", operation);
+    if (!compare && !emit_write(dst, inst_.size(), "result")) {
+      return false;
+    }
+
+    if (arithmetic && !compare) {
+      line("regs.sr.extend = {};", carry("result", inst_.size()));
+    }
+    line("regs.sr.negative = {};", negative("result", inst_.size()));
+    line("regs.sr.zero = {};", zero("result", inst_.size()));
+    if (arithmetic) {
+      line("regs.sr.overflow = {};", overflow("src", "dst", "result", inst_.size(), subtract));
+      line("regs.sr.carry = {};", carry("result", inst_.size()));
+    } else {
+      line("regs.sr.overflow = false;");
+      line("regs.sr.carry = false;");
+    }
+    emit_postincrement(dst);
+    return true;
+  }
+
+  bool emit_address_arithmetic() {
+    if (inst_.size() != Instruction::WordSize && inst_.size() != Instruction::LongSize) {
+      return false;
+    }
+    Operand src{inst_.src()};
+    Operand dst{inst_.dst()};
+
+    if (!emit_read_extended(src, "src", next_pc_)) {
+      return false;
+    }
+    if (!emit_read(dst, Instruction::LongSize, "dst", next_pc_)) {
+      return false;
+    }
+    line("const LongLong result = {};", inst_.kind() == Instruction::AddaKind ? "src + dst" : "dst - src");
+    if (inst_.kind() == Instruction::CmpaKind) {
+      line("regs.sr.negative = {};", negative("result", Instruction::LongSize));
+      line("regs.sr.zero = {};", zero("result", Instruction::LongSize));
+      line("regs.sr.overflow = {};", overflow("src", "dst", "result", Instruction::LongSize, /*subtract=*/true));
+      line("regs.sr.carry = {};", carry("(result ^ src)", Instruction::LongSize));
+    } else if (!emit_write(dst, Instruction::LongSize, "result")) {
+      return false;
+    }
+    emit_postincrement(src);
+    emit_postincrement(dst);
+    return true;
+  }
+
+  bool emit_quick() {
+    if (!is_valid_size(inst_.size())) {
+      return false;
+    }
+    Operand dst{inst_.dst()};
+    const bool subtract = inst_.kind() == Instruction::SubqKind;
+
+    line("const LongLong src = {};", inst_.data() ? inst_.data() : 8);
+    if (!emit_read(dst, inst_.size(), "dst", next_pc_)) {
+      return false;
+    }
+    line("const LongLong result = {};", subtract ? "dst - src" : "src + dst");
+    if (!emit_write(dst, inst_.size(), "result")) {
+      return false;
+    }
+
+    // the address register arithmetic doesn't change the flags
+    if (dst.target.kind() != Target::AddressRegisterKind) {
+      line("regs.sr.negative = {};", negative("result", inst_.size()));
+      line("regs.sr.carry = {};", carry("result", inst_.size()));
+      line("regs.sr.extend = regs.sr.carry;");
+      line("regs.sr.overflow = {};", overflow("src", "dst", "result", inst_.size(), subtract));
+      line("regs.sr.zero = {};", zero("result", inst_.size()));
+    }
+    emit_postincrement(dst);
+    return true;
+  }
+
+  bool emit_unary() {
+    if (!is_valid_size(inst_.size())) {
+      return false;
+    }
+    Operand dst{inst_.dst()};
+
+    // CLR reads the operand too
+    if (!emit_read(dst, inst_.size(), "dst", next_pc_)) {
+      return false;
+    }
+    switch (inst_.kind()) {
+    case Instruction::ClrKind:
+      line("const LongLong result = 0;");
+      break;
+    case Instruction::NotKind:
+      line("const LongLong result = ~dst;");
+      break;
+    default:
+      line("const bool has_overflow = (~dst & {:#x}) == {:#x};", size_mask(inst_.size()),
+           size_mask(inst_.size()) >> 1);
+      line("const LongLong result = ~dst + 1;");
+      break;
+    }
+    if (!emit_write(dst, inst_.size(), "result")) {
+      return false;
+    }
+
+    line("regs.sr.negative = {};", negative("result", inst_.size()));
+    line("regs.sr.zero = {};", zero("result", inst_.size()));
+    if (inst_.kind() == Instruction::NegKind) {
+      line("regs.sr.overflow = has_overflow;");
+      line("regs.sr.carry = {};", carry("result", inst_.size()));
+      line("regs.sr.extend = regs.sr.carry;");
+    } else {
+      line("regs.sr.overflow = false;");
+      line("regs.sr.carry = false;");
+    }
+    emit_postincrement(dst);
+    return true;
+  }
+
+  bool emit_tst() {
+    if (!is_valid_size(inst_.size())) {
+      return false;
+    }
+    Operand src{inst_.src()};
+    if (!emit_read(src, inst_.size(), "src", next_pc_)) {
+      return false;
+    }
+    emit_logic_flags("src", inst_.size());
+    emit_postincrement(src);
+    return true;
+  }
+
+  bool emit_swap() {
+    Operand dst{inst_.dst()};
+    if (!emit_read(dst, Instruction::LongSize, "dst", next_pc_)) {
+      return false;
+    }
+    line("const LongLong result = static_cast<Long>((dst >> 16) | (dst << 16));");
+    if (!emit_write(dst, Instruction::LongSize, "result")) {
+      return false;
+    }
+    emit_logic_flags("result", Instruction::LongSize);
+    emit_postincrement(dst);
+    return true;
+  }
+
+  bool emit_ext() {
+    if (inst_.size() != Instruction::WordSize && inst_.size() != Instruction::LongSize) {
+      return false;
+    }
+    Operand dst{inst_.dst()};
+    if (!emit_read(dst, inst_.size(), "dst", next_pc_)) {
+      return false;
+    }
+    if (inst_.size() == Instruction::WordSize) {
+      line("const LongLong result = ((dst & 0x80) ? 0xFF00 : 0) | (dst & 0xFF);");
+    } else {
+      line("const LongLong result = ((dst & 0x8000) ? 0xFFFF0000 : 0) | (dst & 0xFFFF);");
+    }
+    if (!emit_write(dst, inst_.size(), "result")) {
+      return false;
+    }
+    emit_logic_flags("result", inst_.size());
+    emit_postincrement(dst);
+    return true;
+  }
+
+  bool emit_lea() {
+    Operand src{inst_.src()};
+    Operand dst{inst_.dst()};
+    if (src.target.kind() == Target::AddressIncrementKind || src.target.kind() == Target::AddressDecrementKind) {
+      return false;
+    }
+    const auto address = effective_address(src.target, next_pc_);
+    if (!address) {
+      return false;
+    }
+    return emit_write(dst, Instruction::LongSize, *address);
+  }
+
+  bool emit_bcc() {
+    const auto cond = condition(inst_.condition());
+    const auto target = displace(next_pc_, inst_, /*ignore_parsed_word_always=*/true);
+    if (!cond || !target) {
+      return false;
+    }
+    if (*target == next_pc_ || inst_.condition() == Instruction::FalseCond) {
+      return true;
+    }
+    if (inst_.condition() == Instruction::TrueCond) {
+      emit_jump_to(*target, "");
+      return true;
+    }
+    line("if ({}) {{", *cond);
+    emit_jump_to(*target, "  ");
+    line("}}");
+    return true;
+  }
+
+  bool emit_dbcc() {
+    const auto cond = condition(inst_.condition());
+    if (!cond || inst_.dst().kind() != Target::DataRegisterKind) {
+      return false;
+    }
+    // the displacement is relative to the extension word
+    auto pc = next_pc_;
+    if (static_cast<SignedWord>(inst_.data()) >= 0) {
+      pc -= 2;
+    }
+    const auto target = displace(pc, inst_, /*ignore_parsed_word_always=*/false);
+    if (!target) {
+      return false;
+    }
+    if (inst_.condition() == Instruction::TrueCond) {
+      return true;
+    }
+
+    const auto reg = data_register(inst_.dst().index());
+    line("if (!({})) {{", *cond);
+    line("  const auto counter = static_cast<SignedWord>(static_cast<SignedWord>({}) - 1);", reg);
+    line("  {} = ({} & 0xFFFF0000) | static_cast<Word>(counter);", reg, reg);
+    if (*target != next_pc_) {
+      line("  if (counter != -1) {{");
+      emit_jump_to(*target, "    ");
+      line("  }}");
+    }
+    line("}}");
+    return true;
+  }
+
+  bool emit_bsr() {
+    const auto target = displace(next_pc_, inst_, /*ignore_parsed_word_always=*/true);
+    if (!target) {
+      return false;
+    }
+    // a failed push doesn't stop the instruction
+    line("regs.da[15] -= 4;");
+    line("static_cast<void>(ctx.device.write<Long>(regs.da[15], Long{{{:#08x}}}));", next_pc_);
+    if (*target != next_pc_) {
+      emit_jump_to(*target, "");
+    }
+    return true;
+  }
+
+  bool emit_jump() {
+    const auto& dst = inst_.dst();
+    if (dst.kind() == Target::AddressIncrementKind || dst.kind() == Target::AddressDecrementKind) {
+      return false;
+    }
+    const auto address = effective_address(dst, next_pc_);
+    if (!address) {
+      return false;
+    }
+    line("regs.pc = {};", *address);
+    if (inst_.kind() == Instruction::JsrKind) {
+      line("regs.da[15] -= 4;");
+      line("static_cast<void>(ctx.device.write<Long>(regs.da[15], Long{{{:#08x}}}));", next_pc_);
+    }
+    emit_leave_block();
+    return true;
+  }
+
+  bool emit_rts() {
+    line("if (const auto pc = ctx.device.read<Long>(regs.da[15])) {{");
+    line("  regs.pc = *pc;");
+    line("  regs.da[15] += 4;");
+    line("}}");
+    emit_leave_block();
+    return true;
+  }
+
+  // the N and Z flags of the value, V and C are cleared
+  void emit_logic_flags(std::string_view value, Instruction::Size size) {
+    line("regs.sr.negative = {};", negative(value, size));
+    line("regs.sr.zero = {};", zero(value, size));
+    line("regs.sr.overflow = false;");
+    line("regs.sr.carry = false;");
+  }
+
+  void emit_jump_to(AddressType target, std::string_view indent) {
+    line("{}regs.pc = {:#08x};", indent, target);
+    line("{}return std::nullopt;", indent);
+  }
+
+  // the jump target is known only at run time
+  void emit_leave_block() {
+    line("if (regs.pc & 1) {{");
+    line("  return Error{{Error::UnalignedProgramCounter, \"program counter set at {{:04x}}\", regs.pc}};");
+    line("}}");
+    line("if (regs.pc != {:#08x}) {{", next_pc_);
+    line("  return std::nullopt;");
+    line("}}");
+  }
+
+  // `pc` is the program counter seen by the PC-relative modes
+  std::optional<std::string> effective_address(const Target& target, AddressType pc) const {
+    switch (target.kind()) {
+    case Target::AddressKind:
+    case Target::AddressIncrementKind:
+    case Target::AddressDecrementKind:
+      return address_register(target.index());
+    case Target::AddressDisplacementKind:
+      return add_offset(address_register(target.index()), static_cast<SignedWord>(target.ext_word0()));
+    case Target::AddressIndexKind:
+      return indexed_address(address_register(target.index()), target.ext_word0());
+    case Target::ProgramCounterDisplacementKind:
+      return fmt::format("{:#08x}", static_cast<Long>(pc - 2 + static_cast<SignedWord>(target.ext_word0())));
+    case Target::ProgramCounterIndexKind:
+      return indexed_address(fmt::format("{:#08x}", static_cast<Long>(pc - 2)), target.ext_word0());
+    case Target::AbsoluteShortKind:
+      return fmt::format("{:#x}", static_cast<Long>(static_cast<SignedWord>(target.ext_word0())));
+    case Target::AbsoluteLongKind:
+      return fmt::format("{:#x}", (Long{target.ext_word0()} << 16) + target.ext_word1());
+    case Target::ImmediateKind:
+      return fmt::format("{:#08x}", target.address());
+    default:
+      return std::nullopt;
+    }
+  }
+
+  // the index register is sign-extended from a word unless the extension word says it's a long
+  static std::string indexed_address(std::string_view base, Word ext_word) {
+    const auto index = fmt::format("regs.da[{}]", (ext_word >> 12) & 0xF);
+    const auto displaced = add_offset(base, static_cast<SignedByte>(ext_word & 0xFF));
+    if (ext_word & (1 << 11)) {
+      return fmt::format("{} + {}", displaced, index);
+    }
+    return fmt::format("{} + static_cast<Long>(static_cast<SignedWord>({}))", displaced, index);
+  }
+
+  void emit_predecrement(Operand& operand) {
+    if (operand.decremented) {
+      return;
+    }
+    operand.decremented = true;
+    if (operand.target.kind() == Target::AddressDecrementKind) {
+      line("{} -= {};", address_register(operand.target.index()), step(operand.target));
+    }
+  }
+
+  void emit_postincrement(Operand& operand) {
+    if (operand.incremented) {
+      return;
+    }
+    operand.incremented = true;
+    if (operand.target.kind() == Target::AddressIncrementKind) {
+      line("{} += {};", address_register(operand.target.index()), step(operand.target));
+    }
+  }
+
+  // the stack pointer is kept aligned to a word boundary
+  static Long step(const Target& target) {
+    return target.index() == 7 ? std::max<Long>(target.size(), 2) : target.size();
+  }
+
+  // declares `name` as the operand value zero-extended to `LongLong`, the immediate values are taken from the ROM
+  bool emit_read(Operand& operand, Instruction::Size size, std::string_view name, AddressType pc) {
+    emit_predecrement(operand);
+    const auto& target = operand.target;
+    switch (target.kind()) {
+    case Target::DataRegisterKind:
+      line("const LongLong {} = {} & {:#x};", name, data_register(target.index()), size_mask(size));
+      return true;
+    case Target::AddressRegisterKind:
+      line("const LongLong {} = {} & {:#x};", name, address_register(target.index()), size_mask(size));
+      return true;
+    case Target::ImmediateKind:
+      if (target.address() + size <= rom_.size()) {
+        LongLong value = 0;
+        for (AddressType i = 0; i < size; ++i) {
+          value = (value << 8) | rom_[target.address() + i];
+        }
+        line("const LongLong {} = {:#x};", name, value);
+        return true;
+      }
+      break;
+    default:
+      break;
+    }
+
+    const auto address = effective_address(target, pc);
+    if (!address) {
+      return false;
+    }
+    line("const auto {}_read = ctx.device.read<{}>({});", name, type_name(size), *address);
+    line("if (!{}_read) {{", name);
+    line("  {}return {}_read.error();", on_error_, name);
+    line("}}");
+    line("const LongLong {} = *{}_read;", name, name);
+    return true;
+  }
+
+  // the word-sized source of the address register instructions is sign-extended
+  bool emit_read_extended(Operand& operand, std::string_view name, AddressType pc) {
+    if (inst_.size() == Instruction::LongSize) {
+      return emit_read(operand, Instruction::LongSize, name, pc);
+    }
+    const auto raw_name = fmt::format("{}_word", name);
+    if (!emit_read(operand, Instruction::WordSize, raw_name, pc)) {
+      return false;
+    }
+    line("const LongLong {} = static_cast<SignedLongLong>(static_cast<SignedWord>({}));", name, raw_name);
+    return true;
+  }
+
+  // the register writes keep the bits above `size`
+  bool emit_write(Operand& operand, Instruction::Size size, std::string_view value) {
+    emit_predecrement(operand);
+    const auto& target = operand.target;
+    if (target.kind() == Target::DataRegisterKind || target.kind() == Target::AddressRegisterKind) {
+      const auto reg = target.kind() == Target::DataRegisterKind ? data_register(target.index())
+                                                                  : address_register(target.index());
+      if (size == Instruction::LongSize) {
+        line("{} = static_cast<Long>({});", reg, value);
+      } else {
+        line("{} = ({} & {:#x}) | (static_cast<Long>({}) & {:#x});", reg, reg, ~size_mask(size) & 0xFFFFFFFF, value,
+             size_mask(size));
+      }
+      return true;
+    }
+
+    const auto address = effective_address(target, next_pc_);
+    if (!address) {
+      return false;
+    }
+    const auto type = type_name(size);
+    line("if (auto err = ctx.device.write<{}>({}, static_cast<{}>({}))) {{", type, *address, type, value);
+    line("  return err;");
+    line("}}");
+    return true;
+  }
+
+private:
+  const Instruction& inst_;
+  const AddressType next_pc_;
+  const DataView rom_;
+
+  std::string code_;
+  // the code before returning a read error
+  std::string on_error_;
+};
+
+void emit_block(std::string& out, const CodeWalker::BasicBlock& block, DataView rom) {
+  auto it = std::back_inserter(out);
+  fmt::format_to(it, "std::optional<Error> {}(m68k::Context ctx, uint32_t& executed) {{\n", block_name(block.begin));
+  fmt::format_to(it, "  auto& regs = ctx.registers;\n");
+  fmt::format_to(it, "  executed = 0;\n");
+  for (const auto& decoded : block.instructions) {
+    fmt::format_to(it, "  {{\n");
+    fmt::format_to(it, "    // {:06x}: {}\n", decoded.pc, decoded.instruction.print());
+    fmt::format_to(it, "    regs.pc = {:#08x};\n", decoded.next_pc);
+    fmt::format_to(it, "    ++executed;\n");
+    if (auto code = InstructionEmitter{decoded, rom}.emit()) {
+      out += *code;
+    } else {
+      // the interpreter executes the rest
+      fmt::format_to(it, "    auto inst = {};\n", emit_instruction(decoded.instruction));
+      fmt::format_to(it, "    if (auto err = inst.execute(ctx)) {{\n");
+      fmt::format_to(it, "      return err;\n");
+      fmt::format_to(it, "    }}\n");
+      // leave the block if the control flow went elsewhere (traps, branches)
+      fmt::format_to(it, "    if (regs.pc != {:#08x}) {{\n", decoded.next_pc);
+      fmt::format_to(it, "      return std::nullopt;\n");
+      fmt::format_to(it, "    }}\n");
+    }
+    fmt::format_to(it, "  }}\n");
+  }
+  fmt::format_to(it, "  return std::nullopt;\n");
+  fmt::format_to(it, "}}\n\n");
+}
+
+} // namespace
+
+std::string emit_recompiled_source(DataView rom, const std::vector<CodeWalker::BasicBlock>& blocks,
+                                   uint64_t rom_hash) {
+  std::string out;
+  auto it = std::back_inserter(out);
+
+  out += "// generated by sega_recompile, do not edit\n";
+  out += "#include \"lib/common/error/error.h\"\n";
+  out += "#include \"lib/common/memory/types.h\"\n";
+  out += "#include \"lib/m68k/common/context.h\"\n";
+  out += "#include \"lib/m68k/instruction/instruction.h\"\n";
+  out += "#include \"lib/m68k/target/target.h\"\n";
+  out += "#include \"lib/sega/recompiler/recompiled_block.h\"\n";
+  out += "#include <cstddef>\n";
+  out += "#include <cstdint>\n";
+  out += "#include <iterator>\n";
+  out += "#include <optional>\n\n";
+
+  out += "namespace {\n\n";
+  out += "using m68k::Instruction;\n";
+  out += "using m68k::Target;\n\n";
+  for (const auto& block : blocks) {
+    emit_block(out, block, rom);
+  }
+  out += "} // namespace\n\n";
+
+  out += "extern \"C\" {\n\n";
+  out += "extern const sega::RecompiledBlock sega_recompiled_blocks[] = {\n";
+  for (const auto& block : blocks) {
+    fmt::format_to(it, "    {{{:#08x}, {}, &{}}},\n", block.begin, block.instructions.size(), block_name(block.begin));
+  }
+  out += "};\n";
+  out += "extern const size_t sega_recompiled_block_count = std::size(sega_recompiled_blocks);\n";
+  fmt::format_to(it, "extern const uint64_t sega_recompiled_rom_hash = {:#x};\n\n", rom_hash);
+  out += "} // extern \"C\"\n";
+  return out;
+}
+
+} // namespace sega
@@ -0,0 +1,15 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include "lib/sega/recompiler/code_walker.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sega {
+
+// makes a C++ source of a recompiled plugin, see `recompiled_block.h` for its interface;
+// the immediate operands are taken from the ROM
+std::string emit_recompiled_source(DataView rom, const std::vector<CodeWalker::BasicBlock>& blocks,
+                                   uint64_t rom_hash);
+
+} // namespace sega
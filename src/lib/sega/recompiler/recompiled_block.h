@@ -0,0 +1,26 @@
+#pragma once
+#include "lib/common/error/error.h"
+#include "lib/common/memory/types.h"
+#include "lib/m68k/common/context.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace sega {
+
+// executes the basic block starting at the current PC, `executed` is the number of executed instructions,
+// the block returns earlier if the control flow leaves it (e.g. a trap or a taken branch)
+using RecompiledFunction = std::optional<Error> (*)(m68k::Context ctx, uint32_t& executed);
+
+struct RecompiledBlock {
+  AddressType pc;
+  uint32_t instruction_count;
+  RecompiledFunction function;
+};
+
+// symbols exported from a recompiled plugin
+constexpr const char* kRecompiledBlocksSymbol = "sega_recompiled_blocks";
+constexpr const char* kRecompiledBlockCountSymbol = "sega_recompiled_block_count";
+constexpr const char* kRecompiledRomHashSymbol = "sega_recompiled_rom_hash";
+
+} // namespace sega
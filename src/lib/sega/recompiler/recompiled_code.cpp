@@ -0,0 +1,57 @@
+#include "recompiled_code.h"
+#include "lib/sega/recompiler/recompiled_block.h"
+#include "spdlog/spdlog.h"
+#include <cstddef>
+#include <cstdint>
+#include <dlfcn.h>
+#include <string>
+#include <string_view>
+
+namespace sega {
+
+RecompiledCode::~RecompiledCode() {
+  if (handle_) {
+    dlclose(handle_);
+  }
+}
+
+bool RecompiledCode::load(std::string_view path, uint64_t rom_hash) {
+  auto* handle = dlopen(std::string{path}.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!handle) {
+    spdlog::error("can't load recompiled code: {}", dlerror());
+    return false;
+  }
+
+  const auto* blocks = static_cast<const RecompiledBlock*>(dlsym(handle, kRecompiledBlocksSymbol));
+  const auto* block_count = static_cast<const size_t*>(dlsym(handle, kRecompiledBlockCountSymbol));
+  const auto* plugin_rom_hash = static_cast<const uint64_t*>(dlsym(handle, kRecompiledRomHashSymbol));
+  if (!blocks || !block_count || !plugin_rom_hash) {
+    spdlog::error("recompiled code {} doesn't have the block table", path);
+    dlclose(handle);
+    return false;
+  }
+  if (*plugin_rom_hash != rom_hash) {
+    spdlog::error("recompiled code {} is made for another ROM, hash: {:016x} expected: {:016x}", path,
+                  *plugin_rom_hash, rom_hash);
+    dlclose(handle);
+    return false;
+  }
+
+  if (handle_) {
+    dlclose(handle_);
+  }
+  handle_ = handle;
+  blocks_.clear();
+  blocks_.reserve(*block_count);
+  for (size_t i = 0; i < *block_count; ++i) {
+    blocks_.emplace(blocks[i].pc, &blocks[i]);
+  }
+  spdlog::info("loaded recompiled code {} with {} blocks", path, blocks_.size());
+  return true;
+}
+
+size_t RecompiledCode::block_count() const {
+  return blocks_.size();
+}
+
+} // namespace sega
@@ -0,0 +1,43 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include "lib/sega/recompiler/recompiled_block.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+namespace sega {
+
+// basic blocks from a plugin made by `sega_recompile`
+class RecompiledCode {
+public:
+  RecompiledCode() = default;
+  RecompiledCode(const RecompiledCode&) = delete;
+  RecompiledCode(RecompiledCode&&) = delete;
+  ~RecompiledCode();
+
+  // returns false if the plugin can't be loaded or was made for another ROM
+  bool load(std::string_view path, uint64_t rom_hash);
+
+  const RecompiledBlock* find(AddressType pc) const {
+    if (blocks_.empty()) {
+      return nullptr;
+    }
+    const auto it = blocks_.find(pc);
+    return it != blocks_.end() ? it->second : nullptr;
+  }
+
+  // returns the number of removed blocks
+  template<typename Predicate>
+  size_t remove_blocks_if(Predicate predicate) {
+    return std::erase_if(blocks_, [&predicate](const auto& item) { return predicate(*item.second); });
+  }
+
+  size_t block_count() const;
+
+private:
+  void* handle_{};
+  std::unordered_map<AddressType, const RecompiledBlock*> blocks_;
+};
+
+} // namespace sega
@@ -0,0 +1,83 @@
+#include "sn76489.h"
+#include "lib/common/memory/types.h"
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace sega {
+
+namespace {
+
+// 2 dB per attenuation step, a quarter of the range per channel so that the sum doesn't clip
+constexpr std::array<int16_t, 16> kVolumes = {8191, 6506, 5168, 4105, 3261, 2590, 2057, 1634,
+                                              1298, 1031, 819,  651,  517,  411,  326,  0};
+
+// the noise control bits
+constexpr uint16_t kNoiseRateMask = 0b011;
+constexpr uint16_t kWhiteNoise = 0b100;
+
+} // namespace
+
+void Sn76489::write(Byte value) {
+  if (value & 0x80) {
+    // the latch byte sets the low 4 bits
+    latched_channel_ = (value >> 5) & 0b11;
+    latched_attenuation_ = value & 0x10;
+    if (latched_attenuation_) {
+      attenuations_[latched_channel_] = value & 0xF;
+    } else if (latched_channel_ == kNoiseChannel) {
+      periods_[kNoiseChannel] = value & 0b111;
+      lfsr_ = kLfsrReset;
+    } else {
+      periods_[latched_channel_] = (periods_[latched_channel_] & 0x3F0) | (value & 0xF);
+    }
+    return;
+  }
+
+  // the data byte sets the high 6 bits of a tone period or the whole attenuation or noise control
+  if (latched_attenuation_) {
+    attenuations_[latched_channel_] = value & 0xF;
+  } else if (latched_channel_ == kNoiseChannel) {
+    periods_[kNoiseChannel] = value & 0b111;
+    lfsr_ = kLfsrReset;
+  } else {
+    periods_[latched_channel_] = (periods_[latched_channel_] & 0xF) | ((value & 0x3F) << 4);
+  }
+}
+
+void Sn76489::tick(uint64_t ticks) {
+  const auto noise_control = periods_[kNoiseChannel];
+  const auto noise_rate = noise_control & kNoiseRateMask;
+  const uint16_t noise_period = noise_rate == kNoiseRateMask ? periods_[2] : 0x10 << noise_rate;
+
+  for (uint64_t i = 0; i < ticks; ++i) {
+    for (size_t channel = 0; channel < kChannels; ++channel) {
+      if (counters_[channel] > 1) {
+        --counters_[channel];
+        continue;
+      }
+      const auto period = channel == kNoiseChannel ? noise_period : periods_[channel];
+      counters_[channel] = period;
+      outputs_[channel] = !outputs_[channel];
+      if (channel == kNoiseChannel && outputs_[channel]) {
+        // the register shifts on the rising edges, the white noise taps are bits 0 and 3
+        const uint16_t feedback =
+            (noise_control & kWhiteNoise) ? std::popcount(static_cast<uint16_t>(lfsr_ & 0b1001)) & 1 : lfsr_ & 1;
+        lfsr_ = (lfsr_ >> 1) | (feedback << 15);
+      }
+    }
+  }
+}
+
+int16_t Sn76489::sample() const {
+  int sum = 0;
+  for (size_t channel = 0; channel < kNoiseChannel; ++channel) {
+    // periods 0 and 1 hold the output high, the games play samples by the attenuation then
+    const bool high = periods_[channel] <= 1 || outputs_[channel];
+    sum += high ? kVolumes[attenuations_[channel]] : -kVolumes[attenuations_[channel]];
+  }
+  sum += (lfsr_ & 1) ? kVolumes[attenuations_[kNoiseChannel]] : -kVolumes[attenuations_[kNoiseChannel]];
+  return static_cast<int16_t>(sum);
+}
+
+} // namespace sega
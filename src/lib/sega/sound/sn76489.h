@@ -0,0 +1,37 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include <array>
+#include <cstdint>
+
+namespace sega {
+
+// the SN76489 sound generator of the VDP: three square wave channels and a noise channel
+class Sn76489 {
+public:
+  // the chip clock is 7/15 of the 68000 clock and the counters tick every 16 clocks
+  static constexpr uint64_t kTicksPerCycleNumerator = 7;
+  static constexpr uint64_t kTicksPerCycleDenominator = 240;
+
+  void write(Byte value);
+  void tick(uint64_t ticks);
+  int16_t sample() const;
+
+private:
+  static constexpr size_t kChannels = 4;
+  static constexpr size_t kNoiseChannel = 3;
+  static constexpr uint16_t kLfsrReset = 0x8000;
+
+  // the latched channel and the register kind (tone or attenuation)
+  size_t latched_channel_{};
+  bool latched_attenuation_{};
+
+  // 10-bit tone periods, the noise control is the last one
+  std::array<uint16_t, kChannels> periods_{};
+  // 15 is silence
+  std::array<uint8_t, kChannels> attenuations_{0xF, 0xF, 0xF, 0xF};
+  std::array<uint16_t, kChannels> counters_{};
+  std::array<bool, kChannels> outputs_{};
+  uint16_t lfsr_{kLfsrReset};
+};
+
+} // namespace sega
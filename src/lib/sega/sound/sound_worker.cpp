@@ -0,0 +1,94 @@
+#include "sound_worker.h"
+#include "lib/sega/memory/sound_log.h"
+#include <cstdint>
+#include <utility>
+
+namespace sega {
+
+namespace {
+
+// NTSC
+constexpr uint64_t kM68kClock = 7670453;
+// a frame is about 1/60 of a second, the buffer grows if the frames are merged
+constexpr uint64_t kReservedFrames = 4;
+constexpr uint64_t kFramesPerSecond = 60;
+
+} // namespace
+
+SoundWorker::SoundWorker(SoundLog& sound_log, Callback callback, uint64_t sample_rate)
+    : sound_log_{sound_log}, callback_{std::move(callback)}, sample_rate_{sample_rate} {
+  samples_.reserve(kReservedFrames * sample_rate_ / kFramesPerSecond);
+  thread_ = std::thread{[this] { run(); }};
+}
+
+SoundWorker::~SoundWorker() {
+  stop();
+}
+
+void SoundWorker::stop() {
+  if (thread_.joinable()) {
+    sound_log_.stop();
+    thread_.join();
+  }
+}
+
+void SoundWorker::run() {
+  while (const auto* frame = sound_log_.wait_frame()) {
+    render_frame(*frame);
+    sound_log_.pop_frame();
+  }
+}
+
+void SoundWorker::render_frame(const SoundLog::Frame& frame) {
+  samples_.clear();
+  for (const auto& write : frame.writes) {
+    if (write.chip == SoundWrite::Chip::Reset) {
+      reset(write.cycles);
+      continue;
+    }
+    render_until(write.cycles);
+    apply(write);
+  }
+  render_until(frame.end_cycles);
+  callback_(samples_);
+}
+
+void SoundWorker::render_until(uint64_t cycles) {
+  while (true) {
+    const auto sample_cycles = rendered_samples_ * kM68kClock / sample_rate_;
+    if (sample_cycles >= cycles) {
+      break;
+    }
+    const auto ticks = sample_cycles * Sn76489::kTicksPerCycleNumerator / Sn76489::kTicksPerCycleDenominator;
+    psg_.tick(ticks - psg_ticks_);
+    psg_ticks_ = ticks;
+    samples_.push_back(psg_.sample());
+    ++rendered_samples_;
+  }
+}
+
+void SoundWorker::apply(const SoundWrite& write) {
+  switch (write.chip) {
+  case SoundWrite::Chip::Psg:
+    psg_.write(write.value);
+    break;
+  case SoundWrite::Chip::Ym2612Part1:
+    ym2612_registers_[0][write.address] = write.value;
+    break;
+  case SoundWrite::Chip::Ym2612Part2:
+    ym2612_registers_[1][write.address] = write.value;
+    break;
+  case SoundWrite::Chip::Reset:
+    break;
+  }
+}
+
+void SoundWorker::reset(uint64_t cycles) {
+  psg_ = {};
+  ym2612_registers_ = {};
+  // the first sample at or after the new time, the PSG ticks continue from the time itself
+  rendered_samples_ = (cycles * sample_rate_ + kM68kClock - 1) / kM68kClock;
+  psg_ticks_ = cycles * Sn76489::kTicksPerCycleNumerator / Sn76489::kTicksPerCycleDenominator;
+}
+
+} // namespace sega
@@ -0,0 +1,54 @@
+#pragma once
+#include "lib/common/memory/types.h"
+#include "lib/sega/memory/sound_log.h"
+#include "lib/sega/sound/sn76489.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace sega {
+
+// replays the ended frames of the sound log on its own thread, so the synthesis runs in parallel with the emulation
+// of the next frame; only the PSG is synthesized, the YM2612 writes are kept in its register file
+class SoundWorker {
+public:
+  // called on the worker thread with the mono samples of each frame
+  using Callback = std::function<void(std::span<const int16_t> samples)>;
+
+  static constexpr uint64_t kDefaultSampleRate = 44100;
+
+  SoundWorker(SoundLog& sound_log, Callback callback, uint64_t sample_rate = kDefaultSampleRate);
+  SoundWorker(const SoundWorker&) = delete;
+  ~SoundWorker();
+
+  // stops the log and waits until all ended frames are synthesized
+  void stop();
+
+private:
+  void run();
+  void render_frame(const SoundLog::Frame& frame);
+  // renders the samples before the emulated time
+  void render_until(uint64_t cycles);
+  void apply(const SoundWrite& write);
+  void reset(uint64_t cycles);
+
+private:
+  SoundLog& sound_log_;
+  const Callback callback_;
+  const uint64_t sample_rate_;
+
+  Sn76489 psg_;
+  std::array<std::array<Byte, 0x100>, 2> ym2612_registers_{};
+
+  // the emulated time is converted to the samples and the PSG ticks without accumulating rounding errors
+  uint64_t rendered_samples_{};
+  uint64_t psg_ticks_{};
+  std::vector<int16_t> samples_;
+
+  std::thread thread_;
+};
+
+} // namespace sega
@@ -6,6 +6,7 @@
 #include "lib/sega/video/plane.h"
 #include "spdlog/spdlog.h"
 #include <GL/gl.h>
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -18,11 +19,38 @@ namespace sega {
 Video::Video(const VdpDevice& vdp_device) : vdp_device_{vdp_device}, sprite_table_{vdp_device_, colors_} {}
 
 std::span<const uint8_t> Video::update() {
+  if (frame_complete_) {
+    start_frame();
+  }
+  render_lines(rendered_lines_, height_ * kTileDimension);
+  frame_complete_ = true;
+  return canvas_;
+}
+
+void Video::update_lines(size_t line) {
+  if (frame_complete_) {
+    start_frame();
+    frame_complete_ = false;
+  }
+  line = std::min(line, height_ * kTileDimension);
+  if (line > rendered_lines_) {
+    render_lines(rendered_lines_, line);
+  }
+}
+
+void Video::start_frame() {
+  // the size changes only between frames, so the lines are never half-rendered in different sizes
   check_size();
+  rendered_lines_ = 0;
+  uploaded_lines_ = 0;
+}
+
+void Video::render_lines(size_t first, size_t last) {
+  // the palette and the sprites are read with the VDP state at the time of rendering
   colors_.update(vdp_device_.cram_data());
   const auto sprites = sprite_table_.read_sprites();
 
-  auto* canvas_ptr = canvas_.data();
+  auto* canvas_ptr = canvas_.data() + first * width_ * kTileDimension * kBytesPerPixel;
 
   const auto try_draw_sprite = [&](int x, int y, bool priority) -> bool {
     for (const auto& sprite : sprites) {
@@ -184,7 +212,7 @@ std::span<const uint8_t> Video::update() {
   };
 
   // draw each scanline, so iterate from left to right
-  for (int y = 0; y < height_ * kTileDimension; ++y) {
+  for (int y = static_cast<int>(first); y < static_cast<int>(last); ++y) {
     for (int x = 0; x < width_ * kTileDimension; ++x) {
       const bool result = std::invoke([&] -> bool {
         for (const bool priority : {true, false}) {
@@ -215,17 +243,53 @@ std::span<const uint8_t> Video::update() {
       *canvas_ptr++ = 255;
     }
   }
+  rendered_lines_ = last;
+}
 
-  return canvas_;
+void Video::upload_band() {
+  if (rendered_lines_ - uploaded_lines_ >= kBandLines) {
+    upload_lines();
+  }
 }
 
 ImTextureID Video::draw() {
-  glBindTexture(GL_TEXTURE_2D, texture_);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width_ * kTileDimension, height_ * kTileDimension, 0, GL_RGBA,
-               GL_UNSIGNED_BYTE, canvas_.data());
+  upload_lines();
   return texture_;
 }
 
+void Video::upload_lines() {
+  // the texture is allocated lazily, so `update` doesn't need an OpenGL context
+  if (texture_size_changed_) {
+    texture_size_changed_ = false;
+
+    // free old texture if present
+    if (texture_) {
+      glDeleteTextures(1, &texture_);
+    }
+
+    // alloc new texture
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width_ * kTileDimension, height_ * kTileDimension, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    uploaded_lines_ = 0;
+  }
+  if (uploaded_lines_ >= rendered_lines_) {
+    return;
+  }
+
+  // only the lines rendered since the last upload
+  const auto line_bytes = width_ * kTileDimension * kBytesPerPixel;
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, uploaded_lines_, width_ * kTileDimension, rendered_lines_ - uploaded_lines_,
+                  GL_RGBA, GL_UNSIGNED_BYTE, canvas_.data() + uploaded_lines_ * line_bytes);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  uploaded_lines_ = rendered_lines_;
+}
+
 void Video::check_size() {
   bool size_changed{};
   if (const auto vdp_width = vdp_device_.tile_width(); vdp_width != width_) {
@@ -241,20 +305,7 @@ void Video::check_size() {
   if (size_changed) {
     // RGBA encoding
     canvas_.resize((kTileDimension * width_) * (kTileDimension * height_) * 4);
-
-    // free old texture if present
-    if (texture_) {
-      glDeleteTextures(1, &texture_);
-    }
-
-    // alloc new texture if non-zero
-    glGenTextures(1, &texture_);
-    glBindTexture(GL_TEXTURE_2D, texture_);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width_ * kTileDimension, height_ * kTileDimension, 0, GL_RGBA,
-                 GL_UNSIGNED_BYTE, canvas_.data());
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    texture_size_changed_ = true;
   }
 }
 
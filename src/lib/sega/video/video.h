@@ -15,7 +15,15 @@ class Video {
 public:
   Video(const VdpDevice& vdp_device);
 
+  // renders the lines that aren't rendered yet and completes the frame
   std::span<const uint8_t> update();
+  // beam racing: renders the lines above `line` that aren't rendered yet with the current VDP state,
+  // the first call after `update` starts a new frame
+  void update_lines(size_t line);
+
+  // uploads the rendered lines to the texture once there is a band of them, needs an OpenGL context
+  void upload_band();
+  // uploads all rendered lines
   ImTextureID draw();
 
   uint8_t width() const {
@@ -34,8 +42,13 @@ public:
 
 private:
   void check_size();
+  void start_frame();
+  void render_lines(size_t first, size_t last);
+  void upload_lines();
 
 private:
+  static constexpr size_t kBandLines = 16;
+
   const VdpDevice& vdp_device_;
   Colors colors_;
   SpriteTable sprite_table_;
@@ -43,8 +56,12 @@ private:
   uint8_t width_{};  // in tiles
   uint8_t height_{}; // in tiles
   std::vector<uint8_t> canvas_;
+  size_t rendered_lines_{};
+  size_t uploaded_lines_{};
+  bool frame_complete_{true};
 
   GLuint texture_{};
+  bool texture_size_changed_{};
 };
 
 } // namespace sega